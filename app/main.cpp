@@ -1,14 +1,103 @@
+#include <chrono>
+#include <cstdio>
+#include <exception>
 #include <iostream>
+#include <vector>
 
+#include "batch_input.hpp"
+#include "batch_runner.hpp"
 #include "pid.hpp"
+#include "work_stealing_pool.hpp"
 
-int main() {
-  PID pid(0.1, 100.0, -100.0, 0.1, 0.01, 0.5);
+namespace {
 
-  double setpoint = 10.0;  // Desired value
-  double pv = 5.0;         // Process value
+// Upper bound of the THREADS argument; more threads than this only add
+// scheduling overhead.
+const std::size_t kMaxThreads = 1024;
 
-  double result = pid.calculate(setpoint, pv);
+// Parses THREADS: a decimal number in [1, kMaxThreads].
+bool parseThreads(const char *text, std::size_t &threads) {
+  threads = 0;
+  if (*text == '\0') return false;
+  for (const char *p = text; *p != '\0'; ++p) {
+    if (*p < '0' || *p > '9') return false;
+    threads = threads * 10 + static_cast<std::size_t>(*p - '0');
+    if (threads > kMaxThreads) return false;
+  }
+  return threads != 0;
+}
+
+// Processes a whole sample file: CONFIG INPUT OUTPUT [THREADS]; zero threads
+// uses every hardware thread.
+int runBatch(char **argv, std::size_t threads) {
+  auto start = std::chrono::steady_clock::now();
+
+  WorkStealingPool pool(threads);
+  std::vector<ControllerConfig> config = loadConfig(argv[1]);
+  SampleInput input(argv[2], pool);
+  BatchRunner runner(config, pool);
+
+  std::vector<double> outputs(input.size());
+  runner.run(input.data(), input.size(), outputs.data());
+
+  std::FILE *out = std::fopen(argv[3], "wb");
+  if (out == nullptr) {
+    std::perror(argv[3]);
+    return 2;
+  }
+  std::vector<char> buffer(1 << 20);
+  std::setvbuf(out, buffer.data(), _IOFBF, buffer.size());
+  try {
+    if (input.binary())
+      writeBinaryOutputs(out, outputs.data(), outputs.size());
+    else
+      writeCsvOutputs(out, input.data(), outputs.data(), outputs.size(), pool);
+  } catch (...) {
+    std::fclose(out);
+    throw;
+  }
+  if (std::fclose(out) != 0) {
+    std::perror(argv[3]);
+    return 2;
+  }
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cerr << "controllers: " << runner.controllers() << '\n'
+            << "samples:     " << input.size() << '\n'
+            << "threads:     " << pool.threads() << '\n'
+            << "rate:        " << input.bytes() / elapsed.count() / 1e6
+            << " MB/s, " << input.size() / elapsed.count() / 1e6
+            << " M samples/s\n";
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc == 1) {
+    PID pid(0.1, 100.0, -100.0, 0.1, 0.01, 0.5);
+
+    double setpoint = 10.0;  // Desired value
+    double pv = 5.0;         // Process value
+
+    double result = pid.calculate(setpoint, pv);
+
+    std::cout << "output:" << result << std::endl;
+    return 0;
+  }
 
-  std::cout << "output:" << result << std::endl;
+  std::size_t threads = 0;
+  if ((argc != 4 && argc != 5) ||
+      (argc == 5 && !parseThreads(argv[4], threads))) {
+    std::cerr << "usage: " << argv[0] << " [CONFIG INPUT OUTPUT [THREADS]]\n"
+              << "THREADS is a number from 1 to " << kMaxThreads << '\n';
+    return 2;
+  }
+  try {
+    return runBatch(argv, threads);
+  } catch (const std::exception &e) {
+    std::cerr << argv[0] << ": " << e.what() << '\n';
+    return 2;
+  }
 }
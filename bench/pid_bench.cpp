@@ -0,0 +1,483 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "autotuner.hpp"
+#include "batch_input.hpp"
+#include "batch_runner.hpp"
+#include "basic_pid.hpp"
+#include "controller_graph.hpp"
+#include "pid.hpp"
+#include "pid_bank.hpp"
+#include "pid_impl.hpp"
+#include "pid_scheduler.hpp"
+#include "pid_tuning.hpp"
+#include "pid_variants.hpp"
+#include "plant.hpp"
+#include "simulation.hpp"
+
+// Every benchmark feeds the controllers the same alternating process values,
+// so the error flips sign each update and the integral stays bounded.
+namespace {
+
+const double kDt = 0.1;
+const double kMax = 100.0;
+const double kMin = -100.0;
+const double kKp = 0.1;
+const double kKd = 0.01;
+const double kKi = 0.5;
+
+const double kSetpoint = 10.0;
+const double kProcessValues[2] = {8.0, 12.0};
+
+}  // namespace
+
+// Latency of one PID::calculate call through the out-of-line PID wrapper.
+static void BM_PID_Calculate(benchmark::State &state) {
+  PID pid(kDt, kMax, kMin, kKp, kKd, kKi);
+  unsigned i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pid.calculate(kSetpoint, kProcessValues[i & 1]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PID_Calculate);
+
+// Latency of PIDImpl::calculate without the PID wrapper, to isolate the cost of
+// the extra call. PIDImpl is header-only, so this call is inlined.
+static void BM_PIDImpl_Calculate(benchmark::State &state) {
+  PIDImpl pid(kDt, kMax, kMin, kKp, kKd, kKi);
+  unsigned i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pid.calculate(kSetpoint, kProcessValues[i & 1]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PIDImpl_Calculate);
+
+// Cost of creating a million controllers in one reserved vector.
+static void BM_PID_ConstructVector(benchmark::State &state) {
+  const std::size_t count = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    std::vector<PID> pids;
+    pids.reserve(count);
+    for (std::size_t n = 0; n < count; ++n)
+      pids.emplace_back(kDt, kMax, kMin, kKp, kKd, kKi);
+    benchmark::DoNotOptimize(pids.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PID_ConstructVector)->Arg(1 << 20);
+
+// Latency of a header-only PI controller: the derivative term is compiled out.
+static void BM_BasicPID_PI_Calculate(benchmark::State &state) {
+  BasicPID<double, kPI> pid(kDt, kMax, kMin, kKp, kKd, kKi);
+  unsigned i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pid.calculate(kSetpoint, kProcessValues[i & 1]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BasicPID_PI_Calculate);
+
+// Latency of a full BasicPID<double> with optional features enabled one at a
+// time. The kPIDTerms instance is the baseline: a disabled feature must cost
+// nothing, so every other instance is compared against it.
+template <unsigned Terms>
+static void BM_BasicPID_Policy(benchmark::State &state) {
+  BasicPID<double, Terms> pid(kDt, kMax, kMin, kKp, kKd, kKi);
+  unsigned i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pid.calculate(kSetpoint, kProcessValues[i & 1]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_BasicPID_Policy, kPIDTerms);
+BENCHMARK_TEMPLATE(BM_BasicPID_Policy, kPIDTerms | kConditionalIntegration);
+BENCHMARK_TEMPLATE(BM_BasicPID_Policy, kPIDTerms | kBackCalculation);
+BENCHMARK_TEMPLATE(BM_BasicPID_Policy, kPIDTerms | kDerivativeOnMeasurement);
+BENCHMARK_TEMPLATE(BM_BasicPID_Policy, kPIDTerms | kDerivativeFilter);
+BENCHMARK_TEMPLATE(BM_BasicPID_Policy, kPIDTerms | kSetpointWeighting);
+BENCHMARK_TEMPLATE(BM_BasicPID_Policy,
+                   kPIDTerms | kBackCalculation | kDerivativeOnMeasurement |
+                       kDerivativeFilter | kSetpointWeighting);
+
+// Latency of PID::calculate while attached to a PIDTuning that never
+// changes: the cost of polling the version on the hot path.
+static void BM_PID_CalculateWithTuning(benchmark::State &state) {
+  PIDTuning tuning({kMax, kMin, kKp, kKd, kKi});
+  PID pid(kDt, kMax, kMin, kKp, kKd, kKi);
+  pid.setTuning(&tuning);
+  unsigned i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pid.calculate(kSetpoint, kProcessValues[i & 1]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PID_CalculateWithTuning);
+
+// Latency of PID::calculate with statistics attached. Compared with
+// BM_PID_Calculate, this is the overhead budget of the instrumentation: two
+// steady_clock reads plus the bookkeeping in PIDStats::record().
+static void BM_PID_CalculateWithStats(benchmark::State &state) {
+  PIDStats stats;
+  PID pid(kDt, kMax, kMin, kKp, kKd, kKi);
+  pid.setStats(&stats);
+  unsigned i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pid.calculate(kSetpoint, kProcessValues[i & 1]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PID_CalculateWithStats);
+
+// Cost of PIDStats::record() alone, without the clock reads.
+static void BM_PIDStats_Record(benchmark::State &state) {
+  PIDStats stats;
+  std::uint64_t nanos = 20;
+  for (auto _ : state) {
+    stats.record(1.0, 2.0, kMax, kMin, 3.0, nanos);
+    nanos = (nanos * 5 + 3) & 1023;
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PIDStats_Record);
+
+// Taking a snapshot: three percentile scans of the histogram.
+static void BM_PIDStats_Snapshot(benchmark::State &state) {
+  PIDStats stats;
+  for (std::uint64_t n = 0; n < 100000; ++n)
+    stats.record(1.0, 2.0, kMax, kMin, 3.0, 20 + n % 500);
+  for (auto _ : state) benchmark::DoNotOptimize(stats.snapshot());
+}
+BENCHMARK(BM_PIDStats_Snapshot);
+
+// Saving and loading the state of 1M controllers, for warm restarts.
+static void BM_PIDBank_SaveLoadState(benchmark::State &state) {
+  const std::size_t count = 1 << 20;
+  PIDBank bank;
+  bank.reserve(count);
+  for (std::size_t n = 0; n < count; ++n)
+    bank.add(kDt, kMax, kMin, kKp, kKd, kKi);
+
+  for (auto _ : state) {
+    std::stringstream buffer;
+    bank.saveState(buffer);
+    bank.loadState(buffer);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_PIDBank_SaveLoadState)->Unit(benchmark::kMillisecond);
+
+// Latency of PID::calculate with an explicit, jittered dt. Compared with
+// BM_PID_Calculate this adds one division for the reciprocal of dt.
+static void BM_PID_CalculateVariableDt(benchmark::State &state) {
+  PID pid(kDt, kMax, kMin, kKp, kKd, kKi);
+  const double dts[4] = {0.09, 0.1, 0.11, 0.2};
+  unsigned i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        pid.calculate(kSetpoint, kProcessValues[i & 1], dts[i & 3]));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PID_CalculateVariableDt);
+
+// Cost of creating and destroying one PID. The state is stored inline, so no
+// heap allocation is involved.
+static void BM_PID_ConstructDestroy(benchmark::State &state) {
+  for (auto _ : state) {
+    PID pid(kDt, kMax, kMin, kKp, kKd, kKi);
+    benchmark::DoNotOptimize(&pid);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PID_ConstructDestroy);
+
+// One control tick over state.range(0) PID objects stored in one vector.
+static void BM_PID_ManyControllers(benchmark::State &state) {
+  const std::size_t count = static_cast<std::size_t>(state.range(0));
+  std::vector<PID> pids;
+  pids.reserve(count);
+  for (std::size_t n = 0; n < count; ++n)
+    pids.emplace_back(kDt, kMax, kMin, kKp, kKd, kKi);
+
+  unsigned i = 0;
+  for (auto _ : state) {
+    const double pv = kProcessValues[i & 1];
+    for (auto &pid : pids) benchmark::DoNotOptimize(pid.calculate(kSetpoint, pv));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PID_ManyControllers)->RangeMultiplier(8)->Range(1, 1 << 20);
+
+// The same tick over a std::vector of BasicPID<T>: the float and Q16.16
+// controllers take half the memory of the double ones, which matters once
+// the controllers no longer fit in cache.
+template <typename T>
+static void BM_BasicPID_ManyControllers(benchmark::State &state) {
+  const std::size_t count = static_cast<std::size_t>(state.range(0));
+  std::vector<BasicPID<T>> pids(
+      count, BasicPID<T>{T(kDt), T(kMax), T(kMin), T(kKp), T(kKd), T(kKi)});
+
+  const T setpoint(kSetpoint);
+  const T pvs[2] = {T(kProcessValues[0]), T(kProcessValues[1])};
+  unsigned i = 0;
+  for (auto _ : state) {
+    const T pv = pvs[i & 1];
+    for (auto &pid : pids) benchmark::DoNotOptimize(pid.calculate(setpoint, pv));
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          sizeof(BasicPID<T>));
+}
+BENCHMARK_TEMPLATE(BM_BasicPID_ManyControllers, double)
+    ->RangeMultiplier(64)
+    ->Range(1 << 8, 1 << 20);
+BENCHMARK_TEMPLATE(BM_BasicPID_ManyControllers, float)
+    ->RangeMultiplier(64)
+    ->Range(1 << 8, 1 << 20);
+BENCHMARK_TEMPLATE(BM_BasicPID_ManyControllers, Q16_16)
+    ->RangeMultiplier(64)
+    ->Range(1 << 8, 1 << 20);
+
+// The same tick as BM_PID_ManyControllers, run through a PIDBank.
+static void BM_PIDBank_ManyControllers(benchmark::State &state) {
+  const std::size_t count = static_cast<std::size_t>(state.range(0));
+  PIDBank bank;
+  bank.reserve(count);
+  for (std::size_t n = 0; n < count; ++n)
+    bank.add(kDt, kMax, kMin, kKp, kKd, kKi);
+
+  std::vector<double> setpoints(count, kSetpoint);
+  std::vector<double> pvs[2] = {std::vector<double>(count, kProcessValues[0]),
+                                std::vector<double>(count, kProcessValues[1])};
+  std::vector<double> outputs(count);
+
+  unsigned i = 0;
+  for (auto _ : state) {
+    bank.calculate(setpoints.data(), pvs[i & 1].data(), outputs.data());
+    benchmark::ClobberMemory();
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PIDBank_ManyControllers)->RangeMultiplier(8)->Range(1, 1 << 20);
+
+// One tick of 1M controllers on the scheduler with state.range(0) threads.
+static void BM_PIDScheduler_Tick(benchmark::State &state) {
+  const std::size_t count = 1 << 20;
+  PIDScheduler scheduler(static_cast<std::size_t>(state.range(0)));
+  scheduler.reserve(count);
+  for (std::size_t n = 0; n < count; ++n)
+    scheduler.add(kDt, kMax, kMin, kKp, kKd, kKi);
+  for (std::size_t n = 0; n < count; ++n) scheduler.setpoints()[n] = kSetpoint;
+
+  unsigned i = 0;
+  for (auto _ : state) {
+    const double pv = kProcessValues[i & 1];
+    for (std::size_t n = 0; n < count; ++n) scheduler.pvs()[n] = pv;
+    scheduler.tick();
+    state.SetIterationTime(
+        std::chrono::duration<double>(scheduler.lastTickTime()).count());
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_PIDScheduler_Tick)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseManualTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// 1 << 16 independent three-level cascades wired by hand: each inner PID
+// takes the output of its outer PID as setpoint.
+static void BM_PID_HandWiredCascades(benchmark::State &state) {
+  const std::size_t count = 1 << 16;
+  std::vector<PID> pids;
+  pids.reserve(3 * count);
+  for (std::size_t n = 0; n < 3 * count; ++n)
+    pids.emplace_back(kDt, kMax, kMin, kKp, kKd, kKi);
+
+  unsigned i = 0;
+  for (auto _ : state) {
+    const double pv = kProcessValues[i & 1];
+    for (std::size_t n = 0; n < 3 * count; n += 3) {
+      double u = pids[n].calculate(kSetpoint, pv);
+      u = pids[n + 1].calculate(u, pv);
+      benchmark::DoNotOptimize(pids[n + 2].calculate(u, pv));
+    }
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations() * 3 * count);
+}
+BENCHMARK(BM_PID_HandWiredCascades)->Unit(benchmark::kMicrosecond);
+
+// The same cascades compiled into a ControllerPlan, on state.range(0)
+// threads.
+static void BM_ControllerPlan_Tick(benchmark::State &state) {
+  const std::size_t count = 1 << 16;
+  ControllerGraph graph;
+  for (std::size_t n = 0; n < count; ++n) {
+    auto outer = graph.addLoop(kDt, kMax, kMin, kKp, kKd, kKi);
+    auto middle = graph.addLoop(kDt, kMax, kMin, kKp, kKd, kKi);
+    auto inner = graph.addLoop(kDt, kMax, kMin, kKp, kKd, kKi);
+    graph.cascade(outer, middle);
+    graph.cascade(middle, inner);
+  }
+  ControllerPlan plan(graph, static_cast<std::size_t>(state.range(0)));
+  for (std::size_t n = 0; n < count; ++n)
+    plan.setpoints()[plan.slot(3 * n)] = kSetpoint;
+
+  unsigned i = 0;
+  for (auto _ : state) {
+    std::fill(plan.pvs(), plan.pvs() + plan.slots(), kProcessValues[i & 1]);
+    plan.tick();
+    benchmark::ClobberMemory();
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations() * 3 * count);
+}
+BENCHMARK(BM_ControllerPlan_Tick)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// Closed-loop simulation speed: one PID step plus one plant step per item.
+template <typename Plant>
+static void simulateBenchmark(benchmark::State &state, Plant plant) {
+  const std::size_t steps = 1 << 16;
+  for (auto _ : state) {
+    BasicPID<double> pid(0.01, kMax, kMin, 2.0, 0.05, 1.0);
+    Plant p = plant;
+    StepMetrics metrics = simulateStep(pid, p, 1.0, steps, 0.01);
+    benchmark::DoNotOptimize(metrics.iae());
+  }
+  state.SetItemsProcessed(state.iterations() * steps);
+}
+BENCHMARK_CAPTURE(simulateBenchmark, FirstOrderLag, FirstOrderLag(1.0, 0.5, 0.01));
+BENCHMARK_CAPTURE(simulateBenchmark, SecondOrder, SecondOrder(1.0, 5.0, 0.3, 0.01));
+BENCHMARK_CAPTURE(simulateBenchmark, Integrator, Integrator(1.0, 0.01));
+BENCHMARK_CAPTURE(simulateBenchmark, DeadTime,
+                  withDeadTime(FirstOrderLag(1.0, 0.5, 0.01), 20));
+
+// Candidate gain sets evaluated per second by the autotuner's grid search.
+static void BM_Autotuner_GridSearch(benchmark::State &state) {
+  TuneOptions options;
+  options.steps = 1000;
+  options.threads = static_cast<std::size_t>(state.range(0));
+  Autotuner<FirstOrderLag> tuner(FirstOrderLag(1.0, 0.5, 0.01), options);
+  GainRange Kp{0.1, 10.0, 16}, Kd{0.0, 0.1, 4}, Ki{0.1, 10.0, 16};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tuner.gridSearch(Kp, Kd, Ki).cost);
+  }
+  state.SetItemsProcessed(state.iterations() * 16 * 4 * 16);
+}
+BENCHMARK(BM_Autotuner_GridSearch)
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Batch processing: 1M samples for 1000 controllers, in bytes of CSV parsed,
+// samples run and bytes of CSV written per second.
+namespace {
+
+std::vector<Sample> batchSamples() {
+  std::mt19937 random(1);
+  std::vector<Sample> samples(1 << 20);
+  for (Sample &sample : samples)
+    sample = {static_cast<std::uint32_t>(random() % 1000), 0, kSetpoint,
+              static_cast<double>(random() % 40000) / 1000.0 - 20.0};
+  return samples;
+}
+
+std::string batchCsv(const std::vector<Sample> &samples) {
+  std::string text;
+  char line[64];
+  for (const Sample &sample : samples) {
+    int n = std::snprintf(line, sizeof line, "%u,%g,%.3f\n", sample.controller,
+                          sample.setpoint, sample.pv);
+    text.append(line, static_cast<std::size_t>(n));
+  }
+  return text;
+}
+
+}  // namespace
+
+static void BM_Batch_ParseCsv(benchmark::State &state) {
+  const std::string text = batchCsv(batchSamples());
+  WorkStealingPool pool(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    std::vector<Sample> samples =
+        parseCsvSamples(text.data(), text.data() + text.size(), pool);
+    benchmark::DoNotOptimize(samples.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(text.size()));
+}
+BENCHMARK(BM_Batch_ParseCsv)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_Batch_Run(benchmark::State &state) {
+  const std::vector<Sample> samples = batchSamples();
+  std::vector<ControllerConfig> config;
+  for (std::uint32_t id = 0; id < 1000; ++id)
+    config.push_back({id, kDt, kMax, kMin, kKp, kKd, kKi});
+  WorkStealingPool pool(static_cast<std::size_t>(state.range(0)));
+  BatchRunner runner(config, pool);
+  std::vector<double> outputs(samples.size());
+  for (auto _ : state) {
+    runner.run(samples.data(), samples.size(), outputs.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(samples.size()));
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(samples.size() *
+                                                    sizeof(Sample)));
+}
+BENCHMARK(BM_Batch_Run)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_Batch_WriteCsv(benchmark::State &state) {
+  const std::vector<Sample> samples = batchSamples();
+  std::vector<double> outputs(samples.size());
+  for (std::size_t i = 0; i < samples.size(); ++i)
+    outputs[i] = samples[i].pv / 3.0;
+  WorkStealingPool pool(static_cast<std::size_t>(state.range(0)));
+  std::FILE *sink = std::fopen("/dev/null", "wb");
+  for (auto _ : state)
+    writeCsvOutputs(sink, samples.data(), outputs.data(), outputs.size(), pool);
+  std::fclose(sink);
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(samples.size()));
+}
+BENCHMARK(BM_Batch_WriteCsv)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,292 @@
+#include "batch_input.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+
+const char kSampleMagic[8] = {'P', 'I', 'D', 'B', 'A', 'T', 'C', 'H'};
+
+/**
+ * @brief Powers of ten that are exact in a double.
+ */
+const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/**
+ * @brief Offset returned by parseChunk() when the chunk is well formed.
+ */
+const std::size_t kNoError = static_cast<std::size_t>(-1);
+
+/**
+ * @brief Throws a std::system_error for the current errno.
+ */
+[[noreturn]] void throwErrno(const std::string &what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+void skipBlanks(const char *&p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) ++p;
+}
+
+/**
+ * @brief Parses a controller id: decimal digits that fit in 32 bits.
+ */
+bool parseId(const char *&p, const char *end, std::uint32_t &id) {
+  std::uint64_t value = 0;
+  const char *start = p;
+  while (p < end && isDigit(*p)) {
+    value = value * 10 + static_cast<std::uint64_t>(*p - '0');
+    if (value > UINT32_MAX) return false;
+    ++p;
+  }
+  id = static_cast<std::uint32_t>(value);
+  return p != start;
+}
+
+/**
+ * @brief Parses the lines of [begin, end), which starts at a line start.
+ *
+ * @return kNoError, or the offset from @p begin of the first bad line.
+ */
+std::size_t parseChunk(const char *begin, const char *end,
+                       std::vector<Sample> &out) {
+  const char *p = begin;
+  while (p < end) {
+    const char *line = p;
+    skipBlanks(p, end);
+    if (p == end) break;
+    if (*p == '\n' || *p == '\r') {
+      p = static_cast<const char *>(std::memchr(p, '\n', end - p));
+      p = p == nullptr ? end : p + 1;
+      continue;
+    }
+
+    Sample sample = {0, 0, 0, 0};
+    bool ok = parseId(p, end, sample.controller);
+    skipBlanks(p, end);
+    ok = ok && p < end && *p++ == ',';
+    skipBlanks(p, end);
+    ok = ok && parseDouble(p, end, sample.setpoint);
+    skipBlanks(p, end);
+    ok = ok && p < end && *p++ == ',';
+    skipBlanks(p, end);
+    ok = ok && parseDouble(p, end, sample.pv);
+    skipBlanks(p, end);
+    if (ok && p < end && *p == '\r') ++p;
+    ok = ok && (p == end || *p == '\n');
+    if (!ok) return static_cast<std::size_t>(line - begin);
+
+    out.push_back(sample);
+    if (p < end) ++p;
+  }
+  return kNoError;
+}
+
+}  // namespace
+
+bool parseDouble(const char *&p, const char *end, double &value) {
+  const char *start = p;
+  const char *q = p;
+  bool negative = false;
+  if (q < end && (*q == '-' || *q == '+')) negative = *q++ == '-';
+
+  std::uint64_t mantissa = 0;
+  int digits = 0, exponent = 0;
+  bool exact = true, any = false;
+  for (; q < end && isDigit(*q); ++q, any = true) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + static_cast<std::uint64_t>(*q - '0');
+      if (mantissa != 0) ++digits;
+    } else {
+      ++exponent;
+      if (*q != '0') exact = false;
+    }
+  }
+  if (q < end && *q == '.') {
+    for (++q; q < end && isDigit(*q); ++q, any = true) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*q - '0');
+        if (mantissa != 0) ++digits;
+        --exponent;
+      } else if (*q != '0') {
+        exact = false;
+      }
+    }
+  }
+  if (!any) return false;
+
+  if (q < end && (*q == 'e' || *q == 'E')) {
+    const char *e = q + 1;
+    bool negative_exponent = false;
+    if (e < end && (*e == '-' || *e == '+')) negative_exponent = *e++ == '-';
+    if (e < end && isDigit(*e)) {
+      int power = 0;
+      for (; e < end && isDigit(*e); ++e)
+        if (power < 100000) power = power * 10 + (*e - '0');
+      exponent += negative_exponent ? -power : power;
+      q = e;
+    }
+  }
+
+  // Clinger's fast path: both the mantissa and the power of ten are exact
+  // doubles, so one IEEE operation rounds the result correctly.
+  if (exact && mantissa <= (std::uint64_t(1) << 53) && exponent >= -22 &&
+      exponent <= 22) {
+    double result = static_cast<double>(mantissa);
+    result = exponent < 0 ? result / kPow10[-exponent]
+                          : result * kPow10[exponent];
+    value = negative ? -result : result;
+    p = q;
+    return true;
+  }
+
+  // Slow path: strtod needs a terminated copy.
+  std::string text(start, q);
+  char *stop = nullptr;
+  value = std::strtod(text.c_str(), &stop);
+  if (stop != text.c_str() + text.size()) return false;
+  p = q;
+  return true;
+}
+
+SampleFileHeader sampleFileHeader(std::uint64_t count) {
+  SampleFileHeader header;
+  std::memset(&header, 0, sizeof header);
+  std::memcpy(header.magic, kSampleMagic, sizeof header.magic);
+  header.version = kSampleFileVersion;
+  header.record_size = sizeof(Sample);
+  header.count = count;
+  return header;
+}
+
+MappedFile::MappedFile(const std::string &path)
+    : _map(nullptr), _length(0) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throwErrno("cannot open " + path);
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throwErrno("cannot stat " + path);
+  }
+  _length = static_cast<std::size_t>(st.st_size);
+  if (_length > 0) {
+    void *map = ::mmap(nullptr, _length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      ::close(fd);
+      throwErrno("cannot map " + path);
+    }
+    ::madvise(map, _length, MADV_SEQUENTIAL);
+    _map = static_cast<const char *>(map);
+  }
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (_map != nullptr) ::munmap(const_cast<char *>(_map), _length);
+}
+
+const char *MappedFile::data() const { return _map; }
+
+std::size_t MappedFile::size() const { return _length; }
+
+std::vector<Sample> parseCsvSamples(const char *begin, const char *end,
+                                    WorkStealingPool &pool,
+                                    std::size_t chunkBytes) {
+  if (chunkBytes == 0) chunkBytes = 1;
+  const char *const file = begin;
+
+  // Skip a header line.
+  const char *first = begin;
+  while (first < end && (*first == ' ' || *first == '\t')) ++first;
+  if (first < end && !isDigit(*first) && *first != '\n' && *first != '\r') {
+    const char *eol =
+        static_cast<const char *>(std::memchr(first, '\n', end - first));
+    begin = eol == nullptr ? end : eol + 1;
+  }
+
+  // Chunk boundaries, each moved forward to the start of a line.
+  std::vector<const char *> bounds(1, begin);
+  while (bounds.back() < end) {
+    const char *next = bounds.back() + chunkBytes;
+    if (next >= end) {
+      next = end;
+    } else {
+      next = static_cast<const char *>(
+          std::memchr(next - 1, '\n', end - (next - 1)));
+      next = next == nullptr ? end : next + 1;
+    }
+    bounds.push_back(next);
+  }
+
+  const std::size_t chunks = bounds.size() - 1;
+  std::vector<std::vector<Sample>> parts(chunks);
+  std::vector<std::size_t> errors(chunks, kNoError);
+  pool.run(chunks, [&](std::size_t chunk, std::size_t) {
+    // Lines are at least 6 bytes ("0,0,0\n"); reserve for typical lengths.
+    parts[chunk].reserve((bounds[chunk + 1] - bounds[chunk]) / 16);
+    errors[chunk] = parseChunk(bounds[chunk], bounds[chunk + 1], parts[chunk]);
+  });
+  for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+    if (errors[chunk] != kNoError)
+      throw std::runtime_error(
+          "malformed sample at byte " +
+          std::to_string(bounds[chunk] - file + errors[chunk]));
+  }
+
+  // Concatenate the parts in parallel.
+  std::vector<std::size_t> offsets(chunks + 1, 0);
+  for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+    offsets[chunk + 1] = offsets[chunk] + parts[chunk].size();
+  std::vector<Sample> samples(offsets[chunks]);
+  pool.run(chunks, [&](std::size_t chunk, std::size_t) {
+    std::copy(parts[chunk].begin(), parts[chunk].end(),
+              samples.begin() + static_cast<std::ptrdiff_t>(offsets[chunk]));
+    std::vector<Sample>().swap(parts[chunk]);
+  });
+  return samples;
+}
+
+SampleInput::SampleInput(const std::string &path, WorkStealingPool &pool)
+    : _file(path), _samples(nullptr), _count(0), _binary(false) {
+  const char *data = _file.data();
+  const std::size_t size = _file.size();
+  if (size >= sizeof(SampleFileHeader) &&
+      std::memcmp(data, kSampleMagic, sizeof kSampleMagic) == 0) {
+    SampleFileHeader header;
+    std::memcpy(&header, data, sizeof header);
+    if (header.version != kSampleFileVersion ||
+        header.record_size != sizeof(Sample) ||
+        header.count > (size - sizeof header) / sizeof(Sample))
+      throw std::runtime_error(path + " is not a valid sample file");
+    _binary = true;
+    _samples = reinterpret_cast<const Sample *>(data + sizeof header);
+    _count = static_cast<std::size_t>(header.count);
+    return;
+  }
+
+  _parsed = parseCsvSamples(data, data + size, pool);
+  _samples = _parsed.data();
+  _count = _parsed.size();
+}
+
+const Sample *SampleInput::data() const { return _samples; }
+
+std::size_t SampleInput::size() const { return _count; }
+
+bool SampleInput::binary() const { return _binary; }
+
+std::size_t SampleInput::bytes() const { return _file.size(); }
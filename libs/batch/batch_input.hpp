@@ -0,0 +1,140 @@
+#ifndef _BATCH_INPUT_H_
+#define _BATCH_INPUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "work_stealing_pool.hpp"
+
+/**
+ * @brief One input sample: a setpoint and a process value for a controller.
+ *
+ * This is also the record layout of binary sample files, which can therefore
+ * be used straight from the mapping.
+ */
+struct Sample {
+  std::uint32_t controller; /**< Controller id, as in the config */
+  std::uint32_t reserved;   /**< Zero */
+  double setpoint;          /**< Desired value */
+  double pv;                /**< Process value */
+};
+
+static_assert(sizeof(Sample) == 24, "Sample is a file format");
+
+/**
+ * @brief Header of a binary sample file, followed by `count` Samples.
+ */
+struct SampleFileHeader {
+  char magic[8];             /**< "PIDBATCH" */
+  std::uint32_t version;     /**< kSampleFileVersion */
+  std::uint32_t record_size; /**< sizeof(Sample) */
+  std::uint64_t count;       /**< Number of samples */
+};
+
+static_assert(sizeof(SampleFileHeader) == 24, "the header is a file format");
+
+/**
+ * @brief Current binary sample file format version.
+ */
+const std::uint32_t kSampleFileVersion = 1;
+
+/**
+ * @brief Fills a SampleFileHeader for @p count samples.
+ */
+SampleFileHeader sampleFileHeader(std::uint64_t count);
+
+/**
+ * @brief The MappedFile class maps a whole file read-only.
+ *
+ * The kernel is told that the file will be read sequentially, so it reads
+ * ahead aggressively and pages are only loaded when first touched.
+ */
+class MappedFile {
+ public:
+  /**
+   * @brief Opens and maps @p path.
+   *
+   * @throws std::system_error if the file cannot be opened or mapped.
+   */
+  explicit MappedFile(const std::string &path);
+
+  /**
+   * @brief Unmaps the file.
+   */
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const; /**< First byte, or nullptr if empty */
+  std::size_t size() const; /**< Size of the file in bytes */
+
+ private:
+  const char *_map;    /**< Mapping of the whole file */
+  std::size_t _length; /**< Size of the mapping */
+};
+
+/**
+ * @brief Parses CSV samples `controller,setpoint,pv`, one per line.
+ *
+ * The text is cut into chunks of about @p chunkBytes at line boundaries and
+ * the chunks are parsed in parallel on @p pool; the samples keep the order of
+ * the lines. A first line that does not start with a digit is taken as a
+ * header and skipped, as are empty lines. Spaces around fields and CRLF line
+ * ends are accepted. Numbers are converted exactly as std::strtod would.
+ *
+ * @throws std::runtime_error at the first malformed line, with its offset.
+ */
+std::vector<Sample> parseCsvSamples(const char *begin, const char *end,
+                                    WorkStealingPool &pool,
+                                    std::size_t chunkBytes = 1 << 22);
+
+/**
+ * @brief The SampleInput class gives access to the samples of a CSV or binary
+ * sample file.
+ *
+ * Binary files, recognized by their "PIDBATCH" magic, are used in place from
+ * the mapping: opening one copies nothing. CSV files are parsed in parallel
+ * with parseCsvSamples().
+ */
+class SampleInput {
+ public:
+  /**
+   * @brief Opens @p path, parsing it on @p pool if it is CSV.
+   *
+   * @throws std::system_error if the file cannot be read.
+   * @throws std::runtime_error if its content is malformed.
+   */
+  SampleInput(const std::string &path, WorkStealingPool &pool);
+
+  const Sample *data() const; /**< First sample */
+  std::size_t size() const;   /**< Number of samples */
+  bool binary() const;        /**< Whether the file is a binary sample file */
+  std::size_t bytes() const;  /**< Size of the file */
+
+ private:
+  MappedFile _file;             /**< The input file */
+  std::vector<Sample> _parsed;  /**< Samples parsed from CSV */
+  const Sample *_samples;       /**< The samples, parsed or mapped */
+  std::size_t _count;           /**< Number of samples */
+  bool _binary;                 /**< Whether _samples points in the map */
+};
+
+/**
+ * @brief Parses a number like std::strtod, without requiring a terminating
+ * null character.
+ *
+ * Decimal numbers with at most 19 significant digits and a small exponent are
+ * converted with one exactly rounded multiplication or division; anything
+ * else is handed to std::strtod, so the result is always the same.
+ *
+ * @param p     Start of the number; advanced past it on success.
+ * @param end   End of the text.
+ * @param value Receives the number.
+ * @return False if there is no number at @p p.
+ */
+bool parseDouble(const char *&p, const char *end, double &value);
+
+#endif
@@ -0,0 +1,251 @@
+#include "batch_runner.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+/**
+ * @brief Samples per task of the counting sort.
+ */
+const std::size_t kSortChunk = 1 << 16;
+
+/**
+ * @brief Neighbouring controllers that go to the same shard.
+ */
+const std::size_t kControllersPerBlock = 8;
+
+/**
+ * @brief The direct id table is used while it has at most this many entries
+ * per controller; sparser ids are binary searched.
+ */
+const std::size_t kLookupEntriesPerController = 16;
+
+/**
+ * @brief Output lines formatted per task.
+ */
+const std::size_t kFormatChunk = 1 << 15;
+
+/**
+ * @brief Index returned when a chunk has no unknown controller.
+ */
+const std::size_t kNone = static_cast<std::size_t>(-1);
+
+/**
+ * @brief Appends the decimal digits of @p value to @p out.
+ */
+char *formatId(char *out, std::uint32_t value) {
+  char digits[10];
+  int n = 0;
+  do {
+    digits[n++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (n > 0) *out++ = digits[--n];
+  return out;
+}
+
+}  // namespace
+
+constexpr std::uint32_t BatchRunner::kUnknown;
+
+std::vector<ControllerConfig> parseConfig(const char *begin, const char *end) {
+  std::vector<ControllerConfig> config;
+  std::unordered_set<std::uint32_t> seen;
+  std::size_t line_number = 0;
+  const char *p = begin;
+  while (p < end) {
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (eol == nullptr) eol = end;
+    const char *line = p;
+    p = eol == end ? end : eol + 1;
+    ++line_number;
+
+    while (line < eol && (*line == ' ' || *line == '\t')) ++line;
+    if (line == eol || *line == '\r' || *line == '#') continue;
+    if (line_number == 1 && (*line < '0' || *line > '9')) continue;
+
+    auto fail = [&]() -> void {
+      throw std::runtime_error("malformed controller config at line " +
+                               std::to_string(line_number));
+    };
+    ControllerConfig entry;
+    std::uint64_t id = 0;
+    const char *q = line;
+    if (q == eol || *q < '0' || *q > '9') fail();
+    for (; q < eol && *q >= '0' && *q <= '9'; ++q) {
+      id = id * 10 + static_cast<std::uint64_t>(*q - '0');
+      if (id > UINT32_MAX) fail();
+    }
+    entry.id = static_cast<std::uint32_t>(id);
+    double *fields[] = {&entry.dt, &entry.max, &entry.min,
+                        &entry.Kp, &entry.Kd,  &entry.Ki};
+    for (double *field : fields) {
+      while (q < eol && (*q == ' ' || *q == '\t')) ++q;
+      if (q == eol || *q++ != ',') fail();
+      while (q < eol && (*q == ' ' || *q == '\t')) ++q;
+      if (!parseDouble(q, eol, *field)) fail();
+    }
+    while (q < eol && (*q == ' ' || *q == '\t' || *q == '\r')) ++q;
+    if (q != eol) fail();
+
+    if (!seen.insert(entry.id).second)
+      throw std::runtime_error("duplicate controller id " +
+                               std::to_string(entry.id) + " at line " +
+                               std::to_string(line_number));
+    config.push_back(entry);
+  }
+  return config;
+}
+
+std::vector<ControllerConfig> loadConfig(const std::string &path) {
+  MappedFile file(path);
+  return parseConfig(file.data(), file.data() + file.size());
+}
+
+BatchRunner::BatchRunner(const std::vector<ControllerConfig> &config,
+                         WorkStealingPool &pool, std::size_t shards)
+    : _pool(pool), _shards(shards != 0 ? shards : pool.threads() * 8) {
+  std::vector<ControllerConfig> sorted(config);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const ControllerConfig &a, const ControllerConfig &b) {
+              return a.id < b.id;
+            });
+  _pids.reserve(sorted.size());
+  _ids.reserve(sorted.size());
+  for (const ControllerConfig &entry : sorted) {
+    if (!_ids.empty() && _ids.back() == entry.id)
+      throw std::invalid_argument("duplicate controller id " +
+                                  std::to_string(entry.id));
+    _pids.emplace_back(entry.dt, entry.max, entry.min, entry.Kp, entry.Kd,
+                       entry.Ki);
+    _ids.push_back(entry.id);
+  }
+
+  if (!_ids.empty() &&
+      _ids.back() < kLookupEntriesPerController * _ids.size()) {
+    _lookup.assign(std::size_t(_ids.back()) + 1, kUnknown);
+    for (std::size_t k = 0; k < _ids.size(); ++k)
+      _lookup[_ids[k]] = static_cast<std::uint32_t>(k);
+  }
+}
+
+std::size_t BatchRunner::controllers() const { return _pids.size(); }
+
+std::uint32_t BatchRunner::indexOf(std::uint32_t id) const {
+  if (!_lookup.empty()) return id < _lookup.size() ? _lookup[id] : kUnknown;
+  auto it = std::lower_bound(_ids.begin(), _ids.end(), id);
+  if (it == _ids.end() || *it != id) return kUnknown;
+  return static_cast<std::uint32_t>(it - _ids.begin());
+}
+
+void BatchRunner::run(const Sample *samples, std::size_t count,
+                      double *outputs) {
+  const std::size_t chunks = (count + kSortChunk - 1) / kSortChunk;
+  const std::size_t shards = _shards;
+  auto shardOf = [shards](std::uint32_t index) {
+    return (index / kControllersPerBlock) % shards;
+  };
+  auto chunkEnd = [count](std::size_t chunk) {
+    std::size_t end = (chunk + 1) * kSortChunk;
+    return end < count ? end : count;
+  };
+
+  // Map the ids to controllers and count the samples of every
+  // (chunk, shard).
+  std::vector<std::size_t> counts(chunks * shards, 0);
+  std::vector<std::size_t> unknown(chunks, kNone);
+  _index.resize(count);
+  _pool.run(chunks, [&](std::size_t chunk, std::size_t) {
+    std::size_t *row = counts.data() + chunk * shards;
+    for (std::size_t i = chunk * kSortChunk; i < chunkEnd(chunk); ++i) {
+      const std::uint32_t index = indexOf(samples[i].controller);
+      if (index == kUnknown) {
+        if (unknown[chunk] == kNone) unknown[chunk] = i;
+        continue;
+      }
+      _index[i] = index;
+      ++row[shardOf(index)];
+    }
+  });
+  for (std::size_t index : unknown) {
+    if (index != kNone)
+      throw std::out_of_range("sample " + std::to_string(index) +
+                              " refers to unknown controller " +
+                              std::to_string(samples[index].controller));
+  }
+
+  // Stable positions: shard by shard, and chunk by chunk within a shard.
+  std::vector<std::size_t> shard_begin(shards + 1, 0);
+  std::size_t position = 0;
+  for (std::size_t shard = 0; shard < shards; ++shard) {
+    shard_begin[shard] = position;
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+      std::size_t n = counts[chunk * shards + shard];
+      counts[chunk * shards + shard] = position;
+      position += n;
+    }
+  }
+  shard_begin[shards] = position;
+
+  _order.resize(count);
+  _pool.run(chunks, [&](std::size_t chunk, std::size_t) {
+    std::size_t *next = counts.data() + chunk * shards;
+    for (std::size_t i = chunk * kSortChunk; i < chunkEnd(chunk); ++i)
+      _order[next[shardOf(_index[i])]++] = i;
+  });
+
+  // Each shard applies its samples in input order.
+  _pool.run(shards, [&](std::size_t shard, std::size_t) {
+    for (std::size_t k = shard_begin[shard]; k < shard_begin[shard + 1]; ++k) {
+      const std::size_t i = _order[k];
+      outputs[i] = _pids[_index[i]].calculate(samples[i].setpoint,
+                                              samples[i].pv);
+    }
+  });
+}
+
+void writeCsvOutputs(std::FILE *out, const Sample *samples,
+                     const double *outputs, std::size_t count,
+                     WorkStealingPool &pool) {
+  // Format a window of chunks in parallel, then write it, so memory use is
+  // bounded by the window rather than the whole output.
+  const std::size_t window = pool.threads() * 2;
+  std::vector<std::string> buffers(window);
+  for (std::size_t first = 0; first < count; first += window * kFormatChunk) {
+    pool.run(window, [&](std::size_t task, std::size_t) {
+      std::string &buffer = buffers[task];
+      const std::size_t begin = first + task * kFormatChunk;
+      std::size_t end = begin + kFormatChunk;
+      if (end > count) end = count;
+      if (begin >= end) {
+        buffer.clear();
+        return;
+      }
+      // At most 10 digits, a comma, 24 characters of %.17g and a newline.
+      buffer.resize((end - begin) * 36);
+      char *p = &buffer[0];
+      for (std::size_t i = begin; i < end; ++i) {
+        p = formatId(p, samples[i].controller);
+        *p++ = ',';
+        p += std::snprintf(p, 26, "%.17g", outputs[i]);
+        *p++ = '\n';
+      }
+      buffer.resize(static_cast<std::size_t>(p - &buffer[0]));
+    });
+    for (const std::string &buffer : buffers) {
+      if (!buffer.empty() &&
+          std::fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size())
+        throw std::runtime_error("cannot write the outputs");
+    }
+  }
+}
+
+void writeBinaryOutputs(std::FILE *out, const double *outputs,
+                        std::size_t count) {
+  if (count != 0 && std::fwrite(outputs, sizeof(double), count, out) != count)
+    throw std::runtime_error("cannot write the outputs");
+}
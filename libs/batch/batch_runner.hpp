@@ -0,0 +1,129 @@
+#ifndef _BATCH_RUNNER_H_
+#define _BATCH_RUNNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "batch_input.hpp"
+#include "pid.hpp"
+#include "work_stealing_pool.hpp"
+
+/**
+ * @brief Parameters of one controller of a batch, in the order of the PID
+ * constructor.
+ */
+struct ControllerConfig {
+  std::uint32_t id; /**< Id used by the samples */
+  double dt;        /**< Time interval between samples */
+  double max;       /**< Maximum output */
+  double min;       /**< Minimum output */
+  double Kp;        /**< Proportional gain */
+  double Kd;        /**< Derivative gain */
+  double Ki;        /**< Integral gain */
+};
+
+/**
+ * @brief Parses a controller config: one `id,dt,max,min,Kp,Kd,Ki` line per
+ * controller.
+ *
+ * Empty lines, lines starting with '#' and a header line that does not start
+ * with a digit are skipped.
+ *
+ * @throws std::runtime_error on a malformed line or a duplicate id.
+ */
+std::vector<ControllerConfig> parseConfig(const char *begin, const char *end);
+
+/**
+ * @brief Reads and parses the controller config in @p path.
+ *
+ * @throws std::system_error if the file cannot be read.
+ * @throws std::runtime_error if the config is malformed.
+ */
+std::vector<ControllerConfig> loadConfig(const std::string &path);
+
+/**
+ * @brief The BatchRunner class drives one PID per configured controller
+ * through a large array of samples on a thread pool.
+ *
+ * Samples of different controllers are independent, but the samples of one
+ * controller must be applied in order. run() therefore shards the samples by
+ * controller with a stable, parallel counting sort: every shard keeps its
+ * samples in input order and is processed by one thread at a time.
+ *
+ * The PIDs are stored densely in id order, whatever the ids, and each sample's
+ * id is mapped to its PID once per run: through a direct table when the ids
+ * are compact, by binary search otherwise. Blocks of neighbouring PIDs, which
+ * share cache lines, go to the same shard.
+ *
+ * The outputs are the same as calling calculate() on each controller's PID
+ * in input order, whatever the number of threads.
+ */
+class BatchRunner {
+ public:
+  /**
+   * @brief Creates one PID per entry of @p config.
+   *
+   * @param config Controllers; ids need not be contiguous and may be any
+   * 32-bit value.
+   * @param pool   Threads used by run().
+   * @param shards Number of shards; zero uses eight per thread so that work
+   * stealing can balance uneven controllers.
+   *
+   * @throws std::invalid_argument if two controllers have the same id.
+   */
+  BatchRunner(const std::vector<ControllerConfig> &config,
+              WorkStealingPool &pool, std::size_t shards = 0);
+
+  std::size_t controllers() const; /**< Number of configured controllers */
+
+  /**
+   * @brief Processes @p count samples; outputs[i] is the output for
+   * samples[i]. Controllers keep their state across calls.
+   *
+   * @throws std::out_of_range if a sample names an unknown controller; no
+   * controller is updated in that case.
+   */
+  void run(const Sample *samples, std::size_t count, double *outputs);
+
+ private:
+  /**
+   * @brief Returns the position of controller @p id in _pids, or kUnknown.
+   */
+  std::uint32_t indexOf(std::uint32_t id) const;
+
+  static constexpr std::uint32_t kUnknown = UINT32_MAX;
+
+  WorkStealingPool &_pool;            /**< Threads used by run() */
+  std::vector<PID> _pids;             /**< Controllers, in id order */
+  std::vector<std::uint32_t> _ids;    /**< Id of every controller, sorted */
+  std::vector<std::uint32_t> _lookup; /**< Index by id if the ids are compact */
+  std::size_t _shards;                /**< Number of shards */
+  std::vector<std::uint32_t> _index;  /**< Controller index of each sample */
+  std::vector<std::size_t> _order;    /**< Sample indices sorted by shard */
+};
+
+/**
+ * @brief Writes `controller,output` lines for every sample, formatting chunks
+ * of lines in parallel and writing them in order with large fwrite() calls.
+ *
+ * Outputs are printed with 17 significant digits, so they read back to the
+ * same doubles.
+ *
+ * @throws std::runtime_error if writing fails.
+ */
+void writeCsvOutputs(std::FILE *out, const Sample *samples,
+                     const double *outputs, std::size_t count,
+                     WorkStealingPool &pool);
+
+/**
+ * @brief Writes the outputs as raw native doubles, in sample order.
+ *
+ * @throws std::runtime_error if writing fails.
+ */
+void writeBinaryOutputs(std::FILE *out, const double *outputs,
+                        std::size_t count);
+
+#endif
@@ -1,85 +1,16 @@
 #ifndef _PID_SOURCE_
 #define _PID_SOURCE_
 
-#include <cmath>
-
 #include "pid.hpp"
+#include "pid_impl.hpp"
 
 // using namespace std;
 
-/**
- * @brief The PIDImpl class handles the actual PID
- * (Proportional-Integral-Derivative) control logic.
- *
- * This class performs the calculations for the PID controller. It maintains the
- * internal state, such as the integral of the error and the previous error
- * value, and applies the PID formula to compute the controller's output.
- *
- * The interface is provided by the PID class, and this class should only be
- * accessed through the PID class, ensuring a clear separation of interface and
- * implementation.
- */
-
-class PIDImpl {
- public:
-  /**
-   * @brief Constructor for PIDImpl.
-   *
-   * @param dt  Time interval between control loop updates.
-   * @param max Maximum value of the manipulated variable (controller output).
-   * @param min Minimum value of the manipulated variable (controller output).
-   * @param Kp  Proportional gain.
-   * @param Kd  Derivative gain.
-   * @param Ki  Integral gain.
-   *
-   * @details
-   * Initializes the PID controller with the provided gain values (Kp, Ki, Kd),
-   * and the output limits (max, min). The time interval `dt` is used for the
-   * integration and differentiation in the PID formula.
-   */
-  PIDImpl(double dt, double max, double min, double Kp, double Kd, double Ki);
-
-  /**
-   * @brief Destructor for PIDImpl.
-   *
-   * Cleans up any resources used by the PIDImpl class. As of now, no dynamic
-   * memory is allocated, but this ensures that future changes will not lead to
-   * memory leaks.
-   */
-  ~PIDImpl();
-  /**
-   * @brief Calculates the PID output.
-   *
-   * @param setpoint The desired value (target) for the process.
-   * @param pv       The current process value (feedback) from the system.
-   * @return The manipulated variable (output) that will drive the system
-   * towards the setpoint.
-   *
-   * @details
-   * The method computes the control variable based on the error between the
-   * setpoint and the process value. It applies the Proportional, Integral, and
-   * Derivative terms to calculate the control action, and ensures the output is
-   * within the specified range (`max` and `min`).
-   */
-  double calculate(double setpoint, double pv);
-
- private:
-  double _dt;  /**< Time interval between updates */
-  double _max; /**< Maximum output value */
-  double _min; /**< Minimum output value */
-  double _Kp;  /**< Proportional gain */
-  double _Kd;  /**< Derivative gain */
-  double _Ki;  /**< Integral gain */
-  double
-      _pre_error;   /**< Previous error value, used in derivative calculation */
-  double _integral; /**< Accumulated integral of the error */
-};
-
 /**
  * @brief PID constructor.
  *
- * Initializes the PID controller by creating a PIDImpl object. The parameters
- * `dt`, `max`, `min`, `Kp`, `Kd`, and `Ki` are passed to the PIDImpl
+ * Initializes the PID controller by constructing its inline PIDImpl object. The
+ * parameters `dt`, `max`, `min`, `Kp`, `Kd`, and `Ki` are passed to the PIDImpl
  * constructor, which handles the actual implementation.
  *
  * @param dt  Time interval between control loop updates.
@@ -89,9 +20,30 @@ class PIDImpl {
  * @param Kd  Derivative gain.
  * @param Ki  Integral gain.
  */
-PID::PID(double dt, double max, double min, double Kp, double Kd, double Ki) {
-  // Creating new instance of the PIDImpl class with attributes initialized
-  pimpl = new PIDImpl(dt, max, min, Kp, Kd, Ki);
+PID::PID(double dt, double max, double min, double Kp, double Kd, double Ki)
+    : impl(dt, max, min, Kp, Kd, Ki) {}
+
+/**
+ * @brief Times one update and records it in the statistics.
+ *
+ * @param setpoint The desired value for the process.
+ * @param pv       The current process value.
+ * @param step     Callable performing the update and returning the output.
+ */
+template <typename Step>
+double PID::measure(double setpoint, double pv, Step step) {
+#if PID_INSTRUMENTATION
+  std::uint64_t start = StatsClock::ticks();
+  double output = step();
+  std::uint64_t ticks = StatsClock::ticks() - start;
+  stats->record(setpoint - pv, output, impl.max(), impl.min(), impl.integral(),
+                stats->toNanos(ticks));
+  return output;
+#else
+  (void)setpoint;
+  (void)pv;
+  return step();
+#endif
 }
 
 /**
@@ -104,110 +56,167 @@ PID::PID(double dt, double max, double min, double Kp, double Kd, double Ki) {
  *
  * @details
  * This function is a wrapper that calls the actual implementation in the
- * PIDImpl class.
+ * PIDImpl class. When tracing is enabled it also pushes a TraceRecord with the
+ * contribution of each term; both paths compute the same output.
  */
 
 double PID::calculate(double setpoint, double pv) {
+#if PID_INSTRUMENTATION
+  if (stats != nullptr)
+    return measure(setpoint, pv, [&] { return update(setpoint, pv); });
+#endif
+  return update(setpoint, pv);
+}
+
+/**
+ * @brief Calculates the output without recording statistics.
+ */
+double PID::update(double setpoint, double pv) {
+  if (tuning != nullptr) pollTuning();
+
   // Delegate the calculation to the PIDImpl instance
-  return pimpl->calculate(setpoint, pv);
+  if (tracer == nullptr) return impl.calculate(setpoint, pv);
+
+  PIDContributions<double> terms;
+  double output = impl.calculate(setpoint, pv, terms);
+  trace(setpoint, pv, output, terms, impl.dt(), 0);
+  return output;
 }
 
 /**
- * @brief Destructor for the PID class.
+ * @brief Calculates the PID controller's output for a sample taken `dt` after
+ * the previous one.
  *
- * Cleans up the PIDImpl object by deleting it, ensuring proper resource
- * management.
+ * @param setpoint The desired value for the process.
+ * @param pv       The current process value.
+ * @param dt       Time elapsed since the previous sample.
+ * @return The manipulated variable (output).
  */
-PID::~PID() {
-  // Instance deletion to avoid memory leak
-  delete pimpl;
+double PID::calculate(double setpoint, double pv, double dt) {
+#if PID_INSTRUMENTATION
+  if (stats != nullptr)
+    return measure(setpoint, pv, [&] { return update(setpoint, pv, dt); });
+#endif
+  return update(setpoint, pv, dt);
 }
 
 /**
- * @brief PIDImpl constructor implementation.
- *
- * @param dt  Time interval between control loop updates.
- * @param max Maximum value of the manipulated variable.
- * @param min Minimum value of the manipulated variable.
- * @param Kp  Proportional gain.
- * @param Kd  Derivative gain.
- * @param Ki  Integral gain.
- *
- * @details
- * Initializes the internal variables for the PID controller. It sets the
- * initial values of `_pre_error` and `_integral` to zero, as the system has not
- * yet encountered any error.
- */
-PIDImpl::PIDImpl(double dt, double max, double min, double Kp, double Kd,
-                 double Ki)
-    : _dt(dt),
-      _max(max),
-      _min(min),
-      _Kp(Kp),
-      _Kd(Kd),
-      _Ki(Ki),
-      _pre_error(0),
-      _integral(0)
-// Replace these comment lines with the necessary code to
-// pass the dt, max, min, kp, kd and ki to the attributes of the
-// PIDImpl class. Initialize the _pre_error and _integral with zero.
-{}
-
-PIDImpl::~PIDImpl() {
-  // No dynamic memory to clean up, so this can be empty
+ * @brief Calculates the output for an explicit dt without recording
+ * statistics.
+ */
+double PID::update(double setpoint, double pv, double dt) {
+  if (tuning != nullptr) pollTuning();
+  if (tracer == nullptr) return impl.calculate(setpoint, pv, dt);
+
+  PIDContributions<double> terms;
+  double output = impl.calculate(setpoint, pv, dt, terms);
+  trace(setpoint, pv, output, terms, dt, kTraceExplicitDt);
+  return output;
 }
 
 /**
- * @brief Calculates the PID output.
+ * @brief Calculates the PID controller's output for a sample taken at
+ * `timestamp`.
  *
- * @param setpoint The desired target value for the process.
- * @param pv       The current process value.
- * @return The manipulated variable (output) to drive the system towards the
- * setpoint.
+ * @param setpoint  The desired value for the process.
+ * @param pv        The current process value.
+ * @param timestamp Time of the sample.
+ * @return The manipulated variable (output).
  *
  * @details
- * This method implements the full PID control logic:
- * - **Proportional Term**: Reacts to the current error between the setpoint and
- * the process value.
- * - **Integral Term**: Accumulates the past errors over time, helping to
- * eliminate steady-state error.
- * - **Derivative Term**: Reacts to the rate of change of the error, helping to
- * dampen the response.
- *
- * The final output is clamped within the maximum and minimum bounds, ensuring
- * that the controller output stays within feasible limits for the system being
- * controlled.
+ * Only timestamps later than the latest one seen move the clock forward, so an
+ * out-of-order sample does not distort the interval of the next one.
  */
+double PID::calculateAt(double setpoint, double pv, double timestamp) {
+  double dt = has_timestamp ? timestamp - last_timestamp : impl.dt();
+  if (!has_timestamp || timestamp > last_timestamp) {
+    last_timestamp = timestamp;
+    has_timestamp = true;
+  }
+  return calculate(setpoint, pv, dt);
+}
 
-double PIDImpl::calculate(double setpoint, double pv) {
-  // Write a line of code to calculate the error by finding the
-  // Calculate error
-  double error = setpoint - pv;
+/**
+ * @brief Pushes one TraceRecord describing a calculate() call to the tracer.
+ */
+void PID::trace(double setpoint, double pv, double output,
+                const PIDContributions<double> &terms, double dt,
+                std::uint32_t flags) {
+  TraceRecord record = {trace_id, flags,   setpoint, pv,     dt,
+                        output,   terms.p, terms.i,  terms.d};
+  tracer->tryPush(record);
+}
 
-  // Proportional term
-  double Pout = _Kp * error;
+/**
+ * @brief Enables or disables tracing.
+ *
+ * @param ring Ring receiving the trace records, or nullptr to disable tracing.
+ * @param id   Controller id written to the trace records.
+ */
+void PID::setTracer(TraceRing *ring, std::uint32_t id) {
+  tracer = ring;
+  trace_id = id;
+}
 
-  // Integral term
-  _integral += error * _dt;
-  double Iout = _Ki * _integral;
+/**
+ * @brief Enables or disables statistics; a no-op without PID_INSTRUMENTATION.
+ *
+ * @param target Statistics to fill, or nullptr to disable them.
+ */
+void PID::setStats(PIDStats *target) {
+#if PID_INSTRUMENTATION
+  stats = target;
+#else
+  (void)target;
+#endif
+}
 
-  // Derivative term
-  double derivative = (error - _pre_error) / _dt;
-  double Dout = _Kd * derivative;
+/**
+ * @brief Attaches the controller to published parameters.
+ *
+ * @param shared Parameters to follow, or nullptr to detach.
+ */
+void PID::setTuning(const PIDTuning *shared) {
+  tuning = shared;
+  // Versions are even, so an odd one forces the first poll to apply.
+  tuning_version = 1;
+}
 
-  // Total output
-  double output = Pout + Iout + Dout;
+/**
+ * @brief Applies the published parameters when their version changed.
+ */
+void PID::pollTuning() {
+  if (tuning->version() == tuning_version) return;
+  PIDParameters parameters = tuning->load(&tuning_version);
+  impl.retune(parameters.Kp, parameters.Kd, parameters.Ki);
+  impl.setLimits(parameters.max, parameters.min);
+}
 
-  // Clamp output to max/min
-  if (output > _max)
-    output = _max;
-  else if (output < _min)
-    output = _min;
+/**
+ * @brief Changes the gains without a bump in the output.
+ */
+void PID::retune(double Kp, double Kd, double Ki) { impl.retune(Kp, Kd, Ki); }
 
-  // Save error to previous error
-  _pre_error = error;
+/**
+ * @brief Changes the output limits.
+ */
+void PID::setLimits(double max, double min) { impl.setLimits(max, min); }
 
-  return output;
+/**
+ * @brief Primes the state for a switch from manual to automatic control.
+ */
+void PID::bumplessTransfer(double output, double setpoint, double pv) {
+  impl.bumplessTransfer(output, setpoint, pv);
 }
 
+/**
+ * @brief Returns a snapshot of the controller state.
+ */
+PIDState<double> PID::state() const { return impl.state(); }
+
+/**
+ * @brief Restores a snapshot of the controller state.
+ */
+void PID::restore(const PIDState<double> &state) { impl.restore(state); }
+
 #endif
@@ -0,0 +1,88 @@
+#ifndef _ALIGNED_ALLOCATOR_H_
+#define _ALIGNED_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+/**
+ * @brief Size of a cache line on the targets we run on.
+ */
+constexpr std::size_t kCacheLineSize = 64;
+
+/**
+ * @brief Number of doubles in one cache line.
+ */
+constexpr std::size_t kDoublesPerLine = kCacheLineSize / sizeof(double);
+
+/**
+ * @brief Standard allocator that places every allocation at the start of a
+ * cache line.
+ *
+ * @details
+ * Containers using this allocator start on a cache-line boundary, so a range
+ * of elements that begins at a multiple of kCacheLineSize bytes never shares a
+ * cache line with the elements before it. The scheduler and ControllerPlan rely
+ * on this to hand out chunks of controller state to different threads without
+ * false sharing.
+ */
+template <typename T>
+class CacheAlignedAllocator {
+ public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = CacheAlignedAllocator<U>;
+  };
+
+  CacheAlignedAllocator() noexcept {}
+  template <typename U>
+  CacheAlignedAllocator(const CacheAlignedAllocator<U> &) noexcept {}
+
+  /**
+   * @brief Allocates storage for @p n objects, aligned to kCacheLineSize.
+   *
+   * @throws std::bad_alloc if the memory cannot be allocated.
+   */
+  T *allocate(std::size_t n) {
+    void *p = nullptr;
+    std::size_t bytes = n * sizeof(T);
+#ifdef _WIN32
+    p = _aligned_malloc(bytes, kCacheLineSize);
+#else
+    if (posix_memalign(&p, kCacheLineSize, bytes) != 0) p = nullptr;
+#endif
+    if (p == nullptr) throw std::bad_alloc();
+    return static_cast<T *>(p);
+  }
+
+  /**
+   * @brief Releases storage obtained from allocate().
+   */
+  void deallocate(T *p, std::size_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const CacheAlignedAllocator<T> &,
+                const CacheAlignedAllocator<U> &) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const CacheAlignedAllocator<T> &,
+                const CacheAlignedAllocator<U> &) {
+  return false;
+}
+
+#endif
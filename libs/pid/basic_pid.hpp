@@ -0,0 +1,403 @@
+#ifndef _BASIC_PID_H_
+#define _BASIC_PID_H_
+
+#include "pid_policies.hpp"
+
+/**
+ * @brief Bit flags that select the terms compiled into a BasicPID.
+ *
+ * The flags are combined with `|` and passed as the second template argument
+ * of BasicPID. A term that is not selected is removed at compile time: its
+ * code is never generated and its state is never updated.
+ *
+ * The last five flags add optional features on top of the terms. The
+ * anti-windup flags need kClamp and kIntegral, since they act on saturation
+ * of the output and on the integral. kDerivativeOnMeasurement takes precedence
+ * over the D weight of kSetpointWeighting.
+ */
+enum PIDTerms : unsigned {
+  kProportional = 1u << 0, /**< Proportional term, Kp * error */
+  kIntegral = 1u << 1,     /**< Integral term, Ki * sum(error * dt) */
+  kDerivative = 1u << 2,   /**< Derivative term, Kd * d(error)/dt */
+  kClamp = 1u << 3,        /**< Clamp the output to [min, max] */
+  kConditionalIntegration = 1u << 4, /**< Anti-windup: stop integrating
+                                          into saturation */
+  kBackCalculation = 1u << 5,        /**< Anti-windup: unwind the integral
+                                          while saturated */
+  kDerivativeOnMeasurement = 1u << 6, /**< D acts on -pv: no setpoint kick */
+  kDerivativeFilter = 1u << 7,        /**< Low-pass filter on the D term */
+  kSetpointWeighting = 1u << 8,       /**< Weights b, c on the setpoint */
+  kPI = kProportional | kIntegral | kClamp,  /**< PI controller */
+  kPD = kProportional | kDerivative | kClamp, /**< PD controller */
+  kPIDTerms = kProportional | kIntegral | kDerivative | kClamp /**< Full PID */
+};
+
+/**
+ * @brief Contributions of the individual terms to one PID output, before the
+ * clamp. Terms that are compiled out are reported as zero.
+ */
+template <typename T>
+struct PIDContributions {
+  T p; /**< Proportional term, Kp * error */
+  T i; /**< Integral term, Ki * integral */
+  T d; /**< Derivative term, Kd * derivative */
+};
+
+/**
+ * @brief Dynamic state of a BasicPID, as returned by BasicPID::state().
+ *
+ * Restoring it into a controller with the same parameters resumes the control
+ * loop exactly where the snapshot was taken.
+ */
+template <typename T>
+struct PIDState {
+  T integral;  /**< Accumulated error * dt */
+  T pre_error; /**< Input of the derivative at the previous sample */
+  T filtered;  /**< Filtered derivative; zero without kDerivativeFilter */
+};
+
+/**
+ * @brief The BasicPID class is a header-only PID controller specialized at
+ * compile time.
+ *
+ * @tparam T     Numeric type of the gains, limits, state and output. Any type
+ * with the arithmetic and comparison operators and a conversion from 0 works:
+ * float, double, or a fixed-point class.
+ * @tparam Terms Combination of PIDTerms flags selecting the terms to compile.
+ *
+ * @details
+ * Everything is defined inline so that the compiler can inline calculate()
+ * into the control loop and constant-fold gains known at compile time. The
+ * constructor is constexpr, so controllers can be built in constant
+ * expressions.
+ *
+ * PIDImpl, behind PID, is a BasicPID<double>. With the default `kPIDTerms`
+ * its output is bit-identical to every PIDBank kernel for the same controller.
+ */
+template <typename T, unsigned Terms = kPIDTerms>
+class BasicPID
+    : private PIDSetpointWeighting<T, (Terms & kSetpointWeighting) != 0>,
+      private PIDDerivativeFilter<T, (Terms & kDerivativeFilter) != 0>,
+      private PIDDerivativeOnMeasurement<
+          T, (Terms & kDerivativeOnMeasurement) != 0>,
+      private PIDBackCalculation<T, (Terms & kBackCalculation) != 0> {
+ public:
+  /**
+   * @brief Constructor for BasicPID.
+   *
+   * @param dt  Time interval between control loop updates.
+   * @param max Maximum value of the manipulated variable (controller output).
+   * @param min Minimum value of the manipulated variable (controller output).
+   * @param Kp  Proportional gain.
+   * @param Kd  Derivative gain.
+   * @param Ki  Integral gain.
+   *
+   * @details
+   * The parameters have the same order as in the PID constructor. The previous
+   * error and the integral start at zero. The reciprocal of dt is computed
+   * once here, so calculate() never divides.
+   */
+  constexpr BasicPID(T dt, T max, T min, T Kp, T Kd, T Ki)
+      : _dt(dt),
+        _inv_dt(T(1) / dt),
+        _max(max),
+        _min(min),
+        _Kp(Kp),
+        _Kd(Kd),
+        _Ki(Ki),
+        _pre_error(0),
+        _integral(0) {}
+
+  /**
+   * @brief Calculates the PID output.
+   *
+   * @param setpoint The desired target value for the process.
+   * @param pv       The current process value.
+   * @return The manipulated variable (output) to drive the system towards the
+   * setpoint.
+   *
+   * @details
+   * The enabled terms are summed in the order P, I, D, and the sum is clamped
+   * to [min, max] when kClamp is selected. The term conditions only depend on
+   * the template arguments, so the disabled branches are removed entirely.
+   */
+  T calculate(T setpoint, T pv) {
+    // Once inlined, the stores into the unused contributions are removed.
+    PIDContributions<T> terms;
+    return calculate(setpoint, pv, terms);
+  }
+
+  /**
+   * @brief Calculates the PID output and reports the contribution of each
+   * term.
+   *
+   * @param setpoint The desired target value for the process.
+   * @param pv       The current process value.
+   * @param terms    Receives the P, I and D contributions to the output.
+   * @return The same output as calculate(setpoint, pv).
+   */
+  T calculate(T setpoint, T pv, PIDContributions<T> &terms) {
+    return update(setpoint, pv, _dt, _inv_dt, true, true, terms);
+  }
+
+  /**
+   * @brief Calculates the PID output for a sample taken @p dt after the
+   * previous one.
+   *
+   * @param setpoint The desired target value for the process.
+   * @param pv       The current process value.
+   * @param dt       Time elapsed since the previous sample.
+   * @return The manipulated variable (output).
+   *
+   * @details
+   * Use this overload when samples arrive at irregular intervals or some are
+   * dropped: the integral and the derivative are computed over the actual
+   * interval. It costs one division, for the reciprocal of @p dt. With
+   * dt equal to the constructor's dt the result is identical to
+   * calculate(setpoint, pv).
+   *
+   * A non-positive @p dt (a repeated or out-of-order sample) holds the state:
+   * the integral and the previous error are left unchanged and the derivative
+   * term is zero.
+   */
+  T calculate(T setpoint, T pv, T dt) {
+    PIDContributions<T> terms;
+    return calculate(setpoint, pv, dt, terms);
+  }
+
+  /**
+   * @brief Same as calculate(setpoint, pv, dt), and reports the contribution
+   * of each term.
+   */
+  T calculate(T setpoint, T pv, T dt, PIDContributions<T> &terms) {
+    if (dt > T(0))
+      return update(setpoint, pv, dt, T(1) / dt, true, false, terms);
+    return update(setpoint, pv, dt, T(0), false, false, terms);
+  }
+
+  /**
+   * @brief Sets the setpoint weights. Requires kSetpointWeighting.
+   *
+   * @param b Weight of the setpoint in the P term.
+   * @param c Weight of the setpoint in the D term.
+   */
+  void setSetpointWeights(T b, T c) {
+    static_assert((Terms & kSetpointWeighting) != 0,
+                  "setpoint weights need kSetpointWeighting");
+    this->_b = b;
+    this->_c = c;
+  }
+
+  /**
+   * @brief Sets the time constant of the derivative filter. Requires
+   * kDerivativeFilter.
+   *
+   * @param Tf Filter time constant, in the unit of dt; zero disables
+   * filtering.
+   */
+  void setDerivativeFilter(T Tf) {
+    static_assert((Terms & kDerivativeFilter) != 0,
+                  "a derivative filter needs kDerivativeFilter");
+    this->_tf = Tf;
+    this->_alpha = Tf / (Tf + _dt);
+  }
+
+  /**
+   * @brief Sets the back-calculation tracking gain. Requires kBackCalculation.
+   *
+   * @param Kt Tracking gain; larger values unwind the integral faster.
+   */
+  void setTrackingGain(T Kt) {
+    static_assert((Terms & kBackCalculation) != 0,
+                  "a tracking gain needs kBackCalculation");
+    this->_tracking = _Ki != T(0) ? Kt / _Ki : T(0);
+  }
+
+  /**
+   * @brief Changes the gains without a bump in the output.
+   *
+   * The integral is rescaled so that the integral term Ki * integral keeps
+   * its value; only the P and D terms follow the new gains at once. With
+   * kBackCalculation, the ratio Kt / Ki is kept.
+   *
+   * @param Kp Proportional gain.
+   * @param Kd Derivative gain.
+   * @param Ki Integral gain.
+   */
+  void retune(T Kp, T Kd, T Ki) {
+    if ((Terms & kIntegral) && Ki != T(0)) _integral = _Ki * _integral / Ki;
+    _Kp = Kp;
+    _Kd = Kd;
+    _Ki = Ki;
+  }
+
+  /**
+   * @brief Changes the output limits, effective from the next sample.
+   */
+  void setLimits(T max, T min) {
+    _max = max;
+    _min = min;
+  }
+
+  /**
+   * @brief Prepares a switch from manual to automatic control, so that the
+   * first automatic output continues from @p output.
+   *
+   * The previous error is set as if the controller had already seen this
+   * sample, which zeroes the next derivative, and the integral is set so that
+   * calculate() on the current sample gives @p output. That update first adds
+   * error * dt to the integral, so the seed leaves room for it. This needs
+   * kIntegral and a non-zero Ki; otherwise only the derivative is primed.
+   *
+   * @param output   Manual output applied so far.
+   * @param setpoint Current setpoint.
+   * @param pv       Current process value.
+   */
+  void bumplessTransfer(T output, T setpoint, T pv) {
+    T error = setpoint - pv;
+    if (Terms & kDerivative) _pre_error = derivativeInput(setpoint, pv, error);
+    this->seedInput();
+    this->restoreFilter(T(0));
+    if ((Terms & kIntegral) && _Ki != T(0)) {
+      T p = (Terms & kProportional)
+                ? _Kp * this->proportionalError(setpoint, pv, error)
+                : T(0);
+      _integral = (output - p) / _Ki - error * _dt;
+    }
+  }
+
+  /**
+   * @brief Returns a snapshot of the dynamic state.
+   */
+  PIDState<T> state() const {
+    return {_integral, _pre_error, this->filterState()};
+  }
+
+  /**
+   * @brief Restores a snapshot taken with state().
+   */
+  void restore(const PIDState<T> &state) {
+    _integral = state.integral;
+    _pre_error = state.pre_error;
+    this->seedInput();
+    this->restoreFilter(state.filtered);
+  }
+
+  constexpr T dt() const { return _dt; }         /**< Time interval */
+  constexpr T max() const { return _max; }       /**< Maximum output */
+  constexpr T min() const { return _min; }       /**< Minimum output */
+  constexpr T Kp() const { return _Kp; }         /**< Proportional gain */
+  constexpr T Kd() const { return _Kd; }         /**< Derivative gain */
+  constexpr T Ki() const { return _Ki; }         /**< Integral gain */
+  constexpr T integral() const { return _integral; } /**< Integral state */
+  constexpr T preError() const { return _pre_error; } /**< Previous error */
+
+ private:
+  /**
+   * @brief Shared implementation of every calculate() overload.
+   *
+   * @param advance False to compute the output without moving the integral
+   * and the previous error forward in time.
+   * @param nominal True when dt is the constructor's dt, so that values
+   * precomputed for it can be used.
+   */
+  T update(T setpoint, T pv, T dt, T inv_dt, bool advance, bool nominal,
+           PIDContributions<T> &terms) {
+    // Calculate error
+    T error = setpoint - pv;
+    terms.p = terms.i = terms.d = T(0);
+
+    // Proportional term
+    if (Terms & kProportional)
+      terms.p = _Kp * this->proportionalError(setpoint, pv, error);
+
+    // Integral term
+    T previous_integral = _integral;
+    if (Terms & kIntegral) {
+      if (advance) _integral += error * dt;
+      terms.i = _Ki * _integral;
+    }
+
+    // Derivative term, of the error or of the measurement
+    if ((Terms & kDerivative) && advance) {
+      T input = derivativeInput(setpoint, pv, error);
+      T derivative = (input - this->previousInput(input, _pre_error)) * inv_dt;
+      terms.d = _Kd * this->filterDerivative(derivative, dt, nominal);
+      // Save error to previous error
+      _pre_error = input;
+    }
+
+    T unclamped = sum(terms);
+    if (!(Terms & kClamp)) return unclamped;
+    T output = clamp(unclamped);
+
+    if ((Terms & kIntegral) && advance) {
+      // Conditional integration: undo this step's integration when it pushes
+      // the output further into saturation.
+      if ((Terms & kConditionalIntegration) &&
+          ((unclamped > _max && error > T(0)) ||
+           (unclamped < _min && error < T(0)))) {
+        _integral = previous_integral;
+        terms.i = _Ki * _integral;
+        unclamped = sum(terms);
+        output = clamp(unclamped);
+      }
+      // Back-calculation: unwind the integral by the clamped amount.
+      this->backCalculate(_integral, output - unclamped, dt);
+    }
+
+    return output;
+  }
+
+  /**
+   * @brief Returns the signal differentiated by the D term: the weighted
+   * error, or the negated measurement with kDerivativeOnMeasurement.
+   */
+  T derivativeInput(T setpoint, T pv, T error) const {
+    return (Terms & kDerivativeOnMeasurement)
+               ? T(0) - pv
+               : this->derivativeError(setpoint, pv, error);
+  }
+
+  /**
+   * @brief Sums the enabled contributions in the order P, I, D.
+   */
+  static T sum(const PIDContributions<T> &terms) {
+    T output(0);
+    bool any = false;
+    if (Terms & kProportional) {
+      output = terms.p;
+      any = true;
+    }
+    if (Terms & kIntegral) {
+      output = any ? output + terms.i : terms.i;
+      any = true;
+    }
+    if (Terms & kDerivative) output = any ? output + terms.d : terms.d;
+    return output;
+  }
+
+  /**
+   * @brief Clamps @p output to [min, max].
+   */
+  T clamp(T output) const {
+    // Clamp output to max/min
+    if (output > _max)
+      output = _max;
+    else if (output < _min)
+      output = _min;
+    return output;
+  }
+
+  T _dt;        /**< Time interval between updates */
+  T _inv_dt;    /**< Reciprocal of the time interval */
+  T _max;       /**< Maximum output value */
+  T _min;       /**< Minimum output value */
+  T _Kp;        /**< Proportional gain */
+  T _Kd;        /**< Derivative gain */
+  T _Ki;        /**< Integral gain */
+  T _pre_error; /**< Previous error value, used in derivative calculation */
+  T _integral;  /**< Accumulated integral of the error */
+};
+
+#endif
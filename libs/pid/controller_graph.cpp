@@ -0,0 +1,230 @@
+#include "controller_graph.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+namespace {
+
+/**
+ * @brief Builds the incoming edges of each of @p slots slots in compressed row
+ * form: the edges into slot s are [begin[s], begin[s + 1]) of from and gain.
+ */
+template <typename Edge>
+void buildIncoming(const std::vector<Edge> &edges,
+                   const std::vector<std::size_t> &slot, std::size_t slots,
+                   std::vector<std::size_t> &begin,
+                   std::vector<std::size_t> &from, std::vector<double> &gain) {
+  begin.assign(slots + 1, 0);
+  for (const Edge &edge : edges) ++begin[slot[edge.to] + 1];
+  std::partial_sum(begin.begin(), begin.end(), begin.begin());
+
+  from.resize(edges.size());
+  gain.resize(edges.size());
+  std::vector<std::size_t> next(begin.begin(), begin.end() - 1);
+  for (const Edge &edge : edges) {
+    std::size_t n = next[slot[edge.to]]++;
+    from[n] = slot[edge.from];
+    gain[n] = edge.gain;
+  }
+}
+
+/**
+ * @brief Returns the root of @p node in a union-find forest, halving paths on
+ * the way.
+ */
+std::size_t findRoot(std::vector<std::size_t> &parent, std::size_t node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
+}  // namespace
+
+ControllerGraph::Node ControllerGraph::addLoop(double dt, double max,
+                                               double min, double Kp,
+                                               double Kd, double Ki) {
+  _loops.push_back({dt, max, min, Kp, Kd, Ki});
+  return _loops.size() - 1;
+}
+
+void ControllerGraph::cascade(Node outer, Node inner, double gain) {
+  if (outer >= size() || inner >= size())
+    throw std::out_of_range("cascade between unknown loops");
+  _cascades.push_back({outer, inner, gain});
+}
+
+void ControllerGraph::feedForward(Node from, Node to, double gain) {
+  if (from >= size() || to >= size())
+    throw std::out_of_range("feed-forward between unknown loops");
+  _feed_forwards.push_back({from, to, gain});
+}
+
+std::size_t ControllerGraph::size() const { return _loops.size(); }
+
+ControllerPlan::ControllerPlan(const ControllerGraph &graph,
+                               std::size_t threads, std::size_t chunkSize,
+                               bool pinThreads)
+    : _pool(threads, pinThreads) {
+  const std::size_t count = graph.size();
+  if (chunkSize == 0) chunkSize = 1;
+
+  // Adjacency lists over both kinds of edges, and the weakly connected
+  // components they form.
+  std::vector<std::vector<std::size_t>> successors(count);
+  std::vector<std::size_t> inputs(count, 0);
+  std::vector<std::size_t> parent(count);
+  std::iota(parent.begin(), parent.end(), std::size_t(0));
+  for (const auto *edges : {&graph._cascades, &graph._feed_forwards}) {
+    for (const auto &edge : *edges) {
+      successors[edge.from].push_back(edge.to);
+      ++inputs[edge.to];
+      parent[findRoot(parent, edge.from)] = findRoot(parent, edge.to);
+    }
+  }
+
+  // Kahn's algorithm; the level of a loop is the length of the longest path
+  // that reaches it.
+  std::vector<std::size_t> level(count, 0);
+  std::vector<std::size_t> ready;
+  for (std::size_t node = 0; node < count; ++node)
+    if (inputs[node] == 0) ready.push_back(node);
+  std::size_t sorted = 0;
+  while (!ready.empty()) {
+    std::size_t node = ready.back();
+    ready.pop_back();
+    ++sorted;
+    for (std::size_t next : successors[node]) {
+      level[next] = std::max(level[next], level[node] + 1);
+      if (--inputs[next] == 0) ready.push_back(next);
+    }
+  }
+  if (sorted != count)
+    throw std::invalid_argument("the controller graph contains a cycle");
+
+  // Number the components in order of their first node and pack consecutive
+  // components into tasks of at least chunkSize loops.
+  std::vector<std::size_t> component(count);
+  std::vector<std::size_t> component_size;
+  std::vector<std::size_t> index_of_root(count, count);
+  for (std::size_t node = 0; node < count; ++node) {
+    std::size_t root = findRoot(parent, node);
+    if (index_of_root[root] == count) {
+      index_of_root[root] = component_size.size();
+      component_size.push_back(0);
+    }
+    component[node] = index_of_root[root];
+    ++component_size[component[node]];
+  }
+  std::vector<std::size_t> task_of(component_size.size());
+  std::size_t task = 0, filled = 0;
+  for (std::size_t c = 0; c < component_size.size(); ++c) {
+    if (filled >= chunkSize) {
+      ++task;
+      filled = 0;
+    }
+    task_of[c] = task;
+    filled += component_size[c];
+  }
+
+  // Plan order: by task, then by level, then by node.
+  std::vector<std::size_t> order(count);
+  std::iota(order.begin(), order.end(), std::size_t(0));
+  auto key = [&](std::size_t node) {
+    return std::make_tuple(task_of[component[node]], level[node], node);
+  };
+  std::sort(order.begin(), order.end(),
+            [&](std::size_t a, std::size_t b) { return key(a) < key(b); });
+
+  // Every task starts on a cache line, so tasks running on different threads
+  // never share one. The gaps hold idle controllers that no level covers.
+  _slot.resize(count);
+  const std::size_t capacity = count + (task + 1) * kDoublesPerLine;
+  _bank.reserve(capacity);
+  _max.reserve(capacity);
+  _min.reserve(capacity);
+  std::size_t slots = 0;
+  for (std::size_t k = 0; k < count; ++k) {
+    const std::size_t node = order[k];
+    const std::size_t t = task_of[component[node]];
+    const bool new_task = k == 0 || t != task_of[component[order[k - 1]]];
+    if (new_task) {
+      for (; slots % kDoublesPerLine != 0; ++slots) {
+        _bank.add(1.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+        _max.push_back(0);
+        _min.push_back(0);
+      }
+      _tasks.push_back(_levels.size());
+    }
+    if (new_task || level[node] != level[order[k - 1]])
+      _levels.push_back(slots);
+
+    const ControllerGraph::Loop &loop = graph._loops[node];
+    _slot[node] = slots++;
+    _bank.add(loop.dt, loop.max, loop.min, loop.Kp, loop.Kd, loop.Ki);
+    _max.push_back(loop.max);
+    _min.push_back(loop.min);
+  }
+  _tasks.push_back(_levels.size());
+  _levels.push_back(slots);
+
+  buildIncoming(graph._cascades, _slot, slots, _cascade_begin, _cascade_from,
+                _cascade_gain);
+  buildIncoming(graph._feed_forwards, _slot, slots, _ff_begin, _ff_from,
+                _ff_gain);
+
+  _setpoints.assign(slots, 0);
+  _pvs.assign(slots, 0);
+  _outputs.assign(slots, 0);
+  _effective.assign(slots, 0);
+}
+
+std::size_t ControllerPlan::size() const { return _slot.size(); }
+
+std::size_t ControllerPlan::slots() const { return _outputs.size(); }
+
+std::size_t ControllerPlan::tasks() const { return _tasks.size() - 1; }
+
+std::size_t ControllerPlan::threads() const { return _pool.threads(); }
+
+std::size_t ControllerPlan::slot(Node node) const { return _slot.at(node); }
+
+double *ControllerPlan::setpoints() { return _setpoints.data(); }
+
+double *ControllerPlan::pvs() { return _pvs.data(); }
+
+const double *ControllerPlan::outputs() const { return _outputs.data(); }
+
+void ControllerPlan::tick() {
+  _pool.run(tasks(), [this](std::size_t task, std::size_t) { runTask(task); });
+}
+
+void ControllerPlan::runTask(std::size_t task) {
+  double *outputs = _outputs.data();
+  for (std::size_t l = _tasks[task]; l < _tasks[task + 1]; ++l) {
+    const std::size_t first = _levels[l], last = _levels[l + 1];
+
+    // Setpoints from the outer loops, all in earlier levels.
+    for (std::size_t s = first; s < last; ++s) {
+      double setpoint = _setpoints[s];
+      for (std::size_t e = _cascade_begin[s]; e < _cascade_begin[s + 1]; ++e)
+        setpoint += _cascade_gain[e] * outputs[_cascade_from[e]];
+      _effective[s] = setpoint;
+    }
+
+    _bank.calculate(first, last - first, _effective.data() + first,
+                    _pvs.data() + first, outputs + first);
+
+    // Feed-forward on top of the clamped PID outputs.
+    for (std::size_t s = first; s < last; ++s) {
+      if (_ff_begin[s] == _ff_begin[s + 1]) continue;
+      double output = outputs[s];
+      for (std::size_t e = _ff_begin[s]; e < _ff_begin[s + 1]; ++e)
+        output += _ff_gain[e] * outputs[_ff_from[e]];
+      outputs[s] = std::min(std::max(output, _min[s]), _max[s]);
+    }
+  }
+}
@@ -0,0 +1,161 @@
+#ifndef _CONTROLLER_GRAPH_H_
+#define _CONTROLLER_GRAPH_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "pid_bank.hpp"
+#include "work_stealing_pool.hpp"
+
+/**
+ * @brief The ControllerGraph class describes a set of PID loops and the
+ * signals flowing between them.
+ *
+ * Each loop is a node. Two kinds of edges connect them:
+ * - a cascade edge adds `gain * output` of an outer loop to the setpoint of an
+ *   inner loop;
+ * - a feed-forward edge adds `gain * output` of one loop to the output of
+ *   another, which covers the cross-coupling terms of MIMO decouplers.
+ *
+ * The graph only holds the description. A ControllerPlan compiles it into a
+ * flat execution order and runs it; one graph can be compiled several times.
+ */
+class ControllerGraph {
+ public:
+  using Node = std::size_t; /**< Index of a loop, in order of addLoop() */
+
+  /**
+   * @brief Adds a loop; the parameters are the same as for PID.
+   *
+   * @return The node of the new loop.
+   */
+  Node addLoop(double dt, double max, double min, double Kp, double Kd,
+               double Ki);
+
+  /**
+   * @brief Feeds the output of @p outer into the setpoint of @p inner.
+   *
+   * The setpoint of a loop is its external setpoint plus the weighted outputs
+   * of all its outer loops.
+   *
+   * @throws std::out_of_range if a node does not exist.
+   */
+  void cascade(Node outer, Node inner, double gain = 1.0);
+
+  /**
+   * @brief Adds the output of @p from to the output of @p to.
+   *
+   * The sum is added to the clamped PID output of @p to and clamped again to
+   * its [min, max], so it does not affect the loop's integral.
+   *
+   * @throws std::out_of_range if a node does not exist.
+   */
+  void feedForward(Node from, Node to, double gain);
+
+  std::size_t size() const; /**< Number of loops */
+
+ private:
+  friend class ControllerPlan;
+
+  /**
+   * @brief Parameters of one loop.
+   */
+  struct Loop {
+    double dt, max, min, Kp, Kd, Ki;
+  };
+
+  /**
+   * @brief A weighted edge between two loops.
+   */
+  struct Edge {
+    Node from, to;
+    double gain;
+  };
+
+  std::vector<Loop> _loops;          /**< Loops, indexed by node */
+  std::vector<Edge> _cascades;       /**< Output to setpoint edges */
+  std::vector<Edge> _feed_forwards;  /**< Output to output edges */
+};
+
+/**
+ * @brief The ControllerPlan class evaluates a compiled ControllerGraph once
+ * per control tick.
+ *
+ * Compiling splits the graph into its independent subgraphs and sorts each
+ * one topologically. Small subgraphs are grouped into tasks of about
+ * chunkSize loops. Inside a task, the loops are stored level by level: a
+ * level holds the loops whose inputs all come from earlier levels. Every
+ * array, including the PID state in a PIDBank, is laid out in this plan
+ * order, so a tick walks memory linearly and each level is one vectorized
+ * PIDBank call. Each task starts on a cache line, so the arrays may contain
+ * unused slots between tasks.
+ *
+ * A tick runs the tasks on a WorkStealingPool. Loops that depend on each
+ * other are always in the same task, so the outputs do not depend on the
+ * number of threads.
+ *
+ * Typical use: write setpoints() and pvs() at slot(node), call tick(), read
+ * outputs() at slot(node).
+ */
+class ControllerPlan {
+ public:
+  using Node = ControllerGraph::Node;
+
+  /**
+   * @brief Compiles @p graph.
+   *
+   * @param threads    Number of threads, including the caller of tick(). Zero
+   * uses one thread per hardware thread.
+   * @param chunkSize  Minimum number of loops per task, apart from the last.
+   * @param pinThreads Pin each worker thread to its own CPU (Linux only).
+   * @throws std::invalid_argument if the edges form a cycle.
+   */
+  explicit ControllerPlan(const ControllerGraph &graph, std::size_t threads = 0,
+                          std::size_t chunkSize = 1024,
+                          bool pinThreads = false);
+
+  std::size_t size() const;    /**< Number of loops */
+  std::size_t slots() const;   /**< Length of the plan-order arrays */
+  std::size_t tasks() const;   /**< Number of parallel tasks */
+  std::size_t threads() const; /**< Threads used by tick() */
+
+  /**
+   * @brief Returns the position of @p node in the arrays of the plan.
+   */
+  std::size_t slot(Node node) const;
+
+  double *setpoints();           /**< External setpoints, in plan order */
+  double *pvs();                 /**< Process values, in plan order */
+  const double *outputs() const; /**< Outputs of the last tick */
+
+  /**
+   * @brief Updates every loop once, outer loops before the loops they feed.
+   */
+  void tick();
+
+ private:
+  /**
+   * @brief Evaluates the levels of one task.
+   */
+  void runTask(std::size_t task);
+
+  PIDBank _bank;                     /**< State of every loop */
+  PIDBank::Array _setpoints;         /**< External setpoints */
+  PIDBank::Array _pvs;               /**< Process values */
+  PIDBank::Array _outputs;           /**< Outputs */
+  PIDBank::Array _effective;         /**< Setpoints after the cascade edges */
+  PIDBank::Array _max;               /**< Output limits, for feed-forward */
+  PIDBank::Array _min;               /**< Output limits, for feed-forward */
+  std::vector<std::size_t> _slot;    /**< Slot of every node */
+  std::vector<std::size_t> _tasks;   /**< First level of every task, + end */
+  std::vector<std::size_t> _levels;  /**< First slot of every level, + end */
+  std::vector<std::size_t> _cascade_begin; /**< Cascade edges per slot */
+  std::vector<std::size_t> _cascade_from;  /**< Source slot of each edge */
+  std::vector<double> _cascade_gain;       /**< Gain of each edge */
+  std::vector<std::size_t> _ff_begin;      /**< Feed-forward edges per slot */
+  std::vector<std::size_t> _ff_from;       /**< Source slot of each edge */
+  std::vector<double> _ff_gain;            /**< Gain of each edge */
+  WorkStealingPool _pool;                  /**< Threads that run the tasks */
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef _FIXED_POINT_H_
+#define _FIXED_POINT_H_
+
+#include <cstdint>
+
+/**
+ * @brief The FixedPoint class is a saturating Q-format number stored in a
+ * 32-bit integer.
+ *
+ * A value v is stored as round(v * 2^FracBits), so the resolution is
+ * q = 2^-FracBits and the range is [-2^(31-FracBits), 2^(31-FracBits) - q].
+ * Arithmetic is done in 64 bits and the result is saturated to that range
+ * instead of wrapping around, so a controller that runs out of range stays
+ * pinned at the limit like an actuator would.
+ *
+ * Rounding: conversions from double, products and quotients round to the
+ * nearest representable value; sums and differences are exact unless they
+ * saturate. Division by zero saturates to the sign of the dividend.
+ *
+ * The operators are the ones BasicPID needs, so BasicPID<FixedPoint<F>> is a
+ * fixed-point controller with the same calculate() semantics as the floating
+ * point ones.
+ *
+ * @tparam FracBits Number of fractional bits, in [1, 30].
+ */
+template <unsigned FracBits>
+class FixedPoint {
+  static_assert(FracBits >= 1 && FracBits <= 30,
+                "FixedPoint needs 1 to 30 fractional bits");
+
+ public:
+  using Raw = std::int32_t; /**< Storage type */
+
+  static constexpr Raw kRawMax = INT32_MAX; /**< Largest raw value */
+  static constexpr Raw kRawMin = INT32_MIN; /**< Smallest raw value */
+  static constexpr std::int64_t kOne = std::int64_t(1) << FracBits; /**< 1 */
+
+  /**
+   * @brief Constructs zero.
+   */
+  constexpr FixedPoint() : _raw(0) {}
+
+  /**
+   * @brief Converts @p value, rounding to nearest and saturating. NaN
+   * converts to zero.
+   */
+  constexpr explicit FixedPoint(double value) : _raw(fromDouble(value)) {}
+
+  /**
+   * @brief Converts an integer, saturating.
+   */
+  constexpr explicit FixedPoint(int value)
+      : _raw(saturate(std::int64_t(value) * kOne)) {}
+
+  /**
+   * @brief Constructs a value from its raw representation.
+   */
+  static constexpr FixedPoint fromRaw(Raw raw) {
+    FixedPoint value;
+    value._raw = raw;
+    return value;
+  }
+
+  constexpr Raw raw() const { return _raw; } /**< Raw representation */
+
+  /**
+   * @brief Converts to double; exact for every value.
+   */
+  constexpr double toDouble() const { return double(_raw) / double(kOne); }
+
+  constexpr explicit operator double() const { return toDouble(); }
+
+  /**
+   * @brief Resolution of the format, 2^-FracBits.
+   */
+  static constexpr double resolution() { return 1.0 / double(kOne); }
+
+  friend constexpr FixedPoint operator+(FixedPoint a, FixedPoint b) {
+    return fromRaw(saturate(std::int64_t(a._raw) + b._raw));
+  }
+
+  friend constexpr FixedPoint operator-(FixedPoint a, FixedPoint b) {
+    return fromRaw(saturate(std::int64_t(a._raw) - b._raw));
+  }
+
+  friend constexpr FixedPoint operator-(FixedPoint a) {
+    return fromRaw(saturate(-std::int64_t(a._raw)));
+  }
+
+  friend constexpr FixedPoint operator*(FixedPoint a, FixedPoint b) {
+    // The product of two raw values fits in 62 bits, so adding half an ulp
+    // cannot overflow. >> on a negative value is an arithmetic shift on every
+    // supported compiler, which makes this round half up.
+    return fromRaw(saturate(
+        (std::int64_t(a._raw) * b._raw + (std::int64_t(1) << (FracBits - 1))) >>
+        FracBits));
+  }
+
+  friend constexpr FixedPoint operator/(FixedPoint a, FixedPoint b) {
+    if (b._raw == 0)
+      return fromRaw(a._raw > 0 ? kRawMax : a._raw < 0 ? kRawMin : 0);
+    // Round half away from zero.
+    std::int64_t n = std::int64_t(a._raw) * kOne;
+    std::int64_t half = b._raw / 2;
+    if ((n < 0) != (b._raw < 0)) half = -half;
+    return fromRaw(saturate((n + half) / b._raw));
+  }
+
+  FixedPoint &operator+=(FixedPoint b) { return *this = *this + b; }
+  FixedPoint &operator-=(FixedPoint b) { return *this = *this - b; }
+  FixedPoint &operator*=(FixedPoint b) { return *this = *this * b; }
+  FixedPoint &operator/=(FixedPoint b) { return *this = *this / b; }
+
+  friend constexpr bool operator==(FixedPoint a, FixedPoint b) {
+    return a._raw == b._raw;
+  }
+  friend constexpr bool operator!=(FixedPoint a, FixedPoint b) {
+    return a._raw != b._raw;
+  }
+  friend constexpr bool operator<(FixedPoint a, FixedPoint b) {
+    return a._raw < b._raw;
+  }
+  friend constexpr bool operator>(FixedPoint a, FixedPoint b) {
+    return a._raw > b._raw;
+  }
+  friend constexpr bool operator<=(FixedPoint a, FixedPoint b) {
+    return a._raw <= b._raw;
+  }
+  friend constexpr bool operator>=(FixedPoint a, FixedPoint b) {
+    return a._raw >= b._raw;
+  }
+
+ private:
+  static constexpr Raw saturate(std::int64_t value) {
+    return value > kRawMax ? kRawMax
+                           : value < kRawMin ? kRawMin : Raw(value);
+  }
+
+  static constexpr Raw fromDouble(double value) {
+    return value != value ? 0
+           : value * double(kOne) >= double(kRawMax) ? kRawMax
+           : value * double(kOne) <= double(kRawMin)
+               ? kRawMin
+               : Raw(value * double(kOne) + (value < 0 ? -0.5 : 0.5));
+  }
+
+  Raw _raw; /**< value * 2^FracBits */
+};
+
+template <unsigned FracBits>
+constexpr typename FixedPoint<FracBits>::Raw FixedPoint<FracBits>::kRawMax;
+template <unsigned FracBits>
+constexpr typename FixedPoint<FracBits>::Raw FixedPoint<FracBits>::kRawMin;
+template <unsigned FracBits>
+constexpr std::int64_t FixedPoint<FracBits>::kOne;
+
+/**
+ * @brief Q16.16: range about +/-32768, resolution 2^-16 (about 1.5e-5).
+ */
+using Q16_16 = FixedPoint<16>;
+
+#endif
@@ -1,16 +1,13 @@
 #ifndef _PID_H_
 #define _PID_H_
 
-/**
- * @brief Forward declaration of the PIDImpl class.
- * 
- * The actual implementation details of the PID controller will be handled by 
- * the PIDImpl class. This separation allows the user of the PID class to focus
- * on the interface, while the implementational details are handled by the class
- * PIDImpl.
- */
+#include <cstdint>
+
+#include "pid_impl.hpp"
+#include "pid_stats.hpp"
+#include "pid_tuning.hpp"
+#include "trace_ring.hpp"
 
-class PIDImpl;
 /**
  * @brief The PID class provides an interface to a PID (Proportional-Integral-Derivative) controller.
  * 
@@ -18,6 +15,12 @@ class PIDImpl;
  * It is designed as a wrapper around the actual PID implementation (PIDImpl) to 
  * decouple the interface from the implementation. The implementation of the
  * PID controller logic will be handled by the class PIDImpl.
+ *
+ * The PIDImpl object is stored inline, so a PID is a plain value: constructing
+ * one does not allocate, and copies and moves copy the gains and the state.
+ * A std::vector<PID> therefore keeps all of its controllers in one contiguous
+ * allocation; call reserve() first to create a million of them with a single
+ * allocation and iterate them cache-linearly.
  */
 
 class PID
@@ -59,26 +62,193 @@ class PID
          double calculate( double setpoint, double pv );
 
          /**
-         * @brief Declaration for the destructor for the PID class.
+         * @brief Calculates the output for a sample taken @p dt after the previous one.
+         * 
+         * @param setpoint The desired target value for the system.
+         * @param pv       The current process value (feedback) from the system.
+         * @param dt       Time elapsed since the previous sample.
+         * @return The manipulated variable (output).
+         * 
+         * @details
+         * For jittered or dropped samples: the integral and derivative use the actual
+         * interval instead of the constructor's dt. A non-positive dt holds the integral
+         * and the previous error. The constant-dt calculate() stays division-free.
+         */
+
+         double calculate( double setpoint, double pv, double dt );
+
+         /**
+         * @brief Calculates the output for a sample taken at time @p timestamp.
+         * 
+         * @param setpoint  The desired target value for the system.
+         * @param pv        The current process value (feedback) from the system.
+         * @param timestamp Time of the sample, in the same unit as dt.
+         * @return The manipulated variable (output).
+         * 
+         * @details
+         * The interval is the difference with the timestamp of the previous call; the
+         * first call uses the constructor's dt. Repeated or out-of-order timestamps hold
+         * the state, as calculate(setpoint, pv, dt) does for a non-positive dt.
+         */
+
+         double calculateAt( double setpoint, double pv, double timestamp );
+
+         /**
+         * @brief Enables or disables tracing of every calculate() call.
+         * 
+         * @param ring The ring that receives one TraceRecord per call, or nullptr
+         *             to disable tracing.
+         * @param id   Value stored in TraceRecord::controller to tell controllers
+         *             apart in a shared ring.
+         *
+         * @details
+         * Tracing is off by default. When it is on, calculate() also records the
+         * inputs, the output and the P/I/D contributions; the push never blocks,
+         * and records are dropped if the ring is full. A ring is single-producer,
+         * so every PID traced into it must be updated from the same thread.
+         */
+
+         void setTracer( TraceRing *ring, std::uint32_t id );
+
+         /**
+         * @brief Enables or disables statistics on every calculate() call.
+         * 
+         * @param stats The statistics to fill, or nullptr to disable them.
+         *
+         * @details
+         * Statistics are off by default. When they are on, calculate() also times
+         * itself with two StatsClock reads and records the error, saturation,
+         * integral and duration in @p stats. Building with the CMake option
+         * PID_INSTRUMENTATION=OFF compiles the statistics out of calculate():
+         * setStats() then does nothing and calculate() has no extra branch. The
+         * layout of PID does not depend on the option, so code built without
+         * the definition still agrees with the library on sizeof(PID).
+         */
+
+         void setStats( PIDStats *stats );
+
+         /**
+         * @brief Attaches the controller to parameters published by another thread.
+         * 
+         * @param tuning The shared parameters, or nullptr to detach. It must outlive
+         *               the attachment.
+         *
+         * @details
+         * Every calculate() first checks the version of @p tuning, a single atomic
+         * load, and applies new parameters with retune() and setLimits() when it has
+         * changed, so a running loop can be retuned without a mutex and without a
+         * bump. The current parameters are applied at the next calculate().
+         */
+
+         void setTuning( const PIDTuning *tuning );
+
+         /**
+         * @brief Changes the gains, keeping the integral term continuous.
+         * 
+         * @param Kp Proportional gain.
+         * @param Kd Derivative gain.
+         * @param Ki Integral gain.
+         */
+
+         void retune( double Kp, double Kd, double Ki );
+
+         /**
+         * @brief Changes the output limits.
+         * 
+         * @param max Maximum value of the manipulated variable.
+         * @param min Minimum value of the manipulated variable.
+         */
+
+         void setLimits( double max, double min );
+
+         /**
+         * @brief Prepares a bumpless switch from manual to automatic control.
+         * 
+         * @param output   Manual output applied so far.
+         * @param setpoint Current setpoint.
+         * @param pv       Current process value.
+         *
+         * @details
+         * The integral and the previous error are set so that calculate() with the
+         * same setpoint and process value returns @p output again.
+         */
+
+         void bumplessTransfer( double output, double setpoint, double pv );
+
+         /**
+         * @brief Returns a snapshot of the integral and the previous error.
+         */
+
+         PIDState<double> state() const;
+
+         /**
+         * @brief Restores a snapshot taken with state(), e.g. for a warm restart.
+         */
+
+         void restore( const PIDState<double> &state );
+
+         /**
+         * @brief Copy and move operations.
          * 
-         * Cleans up any resources used by the PID controller. The PIDImpl class is responsible
-         * for managing any dynamically allocated memory, so the destructor will ensure 
-         * proper deallocation.
+         * A copy is an independent controller that starts with the same gains,
+         * integral and previous error as the original. Moving is the same as
+         * copying, since there are no resources to transfer.
          */
 
-         ~PID();
+         PID( const PID &other ) = default;
+         PID( PID &&other ) = default;
+         PID &operator=( const PID &other ) = default;
+         PID &operator=( PID &&other ) = default;
          
     private :
         /**
-         * @brief Declaration of a pointer to the PIDImpl object that handles the actual PID logic.
+         * @brief The PIDImpl object that handles the actual PID logic.
          * 
-         * The PIDImpl class will contain the implementation of the PID algorithm, while
-         * the PID class serves as an interface. By using a pointer to the implementation,
-         * we allow for flexible, modular design where the implementation can be changed 
-         * without modifying the interface.
+         * The PIDImpl class contains the implementation of the PID algorithm, while
+         * the PID class serves as an interface. The object is a member rather than
+         * a heap allocation, so the controller's state lives inside the PID itself.
          */
         
-         PIDImpl *pimpl;
+         PIDImpl impl;
+
+         TraceRing *tracer = nullptr;  /**< Ring receiving trace records, if any */
+         std::uint32_t trace_id = 0;   /**< Controller id written to trace records */
+
+         PIDStats *stats = nullptr;          /**< Statistics to fill, if any */
+
+         const PIDTuning *tuning = nullptr;  /**< Published parameters, if any */
+         std::uint64_t tuning_version = 0;   /**< Version of the applied parameters */
+
+         double last_timestamp = 0;    /**< Latest timestamp seen by calculateAt() */
+         bool has_timestamp = false;   /**< Whether calculateAt() was called before */
+
+         /**
+         * @brief Pushes one record to the tracer.
+         */
+
+         void trace( double setpoint, double pv, double output,
+                     const PIDContributions<double> &terms, double dt,
+                     std::uint32_t flags );
+
+         /**
+         * @brief calculate() and calculate(setpoint, pv, dt) without statistics.
+         */
+
+         double update( double setpoint, double pv );
+         double update( double setpoint, double pv, double dt );
+
+         /**
+         * @brief Runs @p step, timing it and recording its result in the stats.
+         */
+
+         template <typename Step>
+         double measure( double setpoint, double pv, Step step );
+
+         /**
+         * @brief Applies the parameters of the tuning if they changed.
+         */
+
+         void pollTuning();
 
 };
 
@@ -0,0 +1,388 @@
+#include "pid_bank.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define PID_BANK_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Pointers to the arrays of the controllers updated by one kernel call,
+ * already offset to the first controller of the range.
+ */
+struct BankView {
+  const double *dt;
+  const double *inv_dt;
+  const double *max;
+  const double *min;
+  const double *Kp;
+  const double *Kd;
+  const double *Ki;
+  double *pre_error;
+  double *integral;
+};
+
+/**
+ * @brief Updates controllers [begin, end) one at a time.
+ *
+ * @details
+ * This is the reference kernel. It repeats the exact sequence of operations of
+ * BasicPID::calculate, and the vector kernels use it for their remainders.
+ */
+inline void calculateScalar(const BankView &b, std::size_t begin,
+                            std::size_t end, const double *setpoints,
+                            const double *pvs, double *outputs) {
+  for (std::size_t i = begin; i < end; ++i) {
+    double error = setpoints[i] - pvs[i];
+
+    double Pout = b.Kp[i] * error;
+
+    b.integral[i] += error * b.dt[i];
+    double Iout = b.Ki[i] * b.integral[i];
+
+    double derivative = (error - b.pre_error[i]) * b.inv_dt[i];
+    double Dout = b.Kd[i] * derivative;
+
+    double output = Pout + Iout + Dout;
+
+    if (output > b.max[i])
+      output = b.max[i];
+    else if (output < b.min[i])
+      output = b.min[i];
+
+    b.pre_error[i] = error;
+    outputs[i] = output;
+  }
+}
+
+void kernelScalar(const BankView &b, std::size_t count,
+                  const double *setpoints, const double *pvs,
+                  double *outputs) {
+  calculateScalar(b, 0, count, setpoints, pvs, outputs);
+}
+
+#ifdef PID_BANK_X86_KERNELS
+
+/**
+ * @brief Updates two controllers per iteration with SSE2 instructions.
+ *
+ * @details
+ * SSE2 has no blend instruction, so the clamp selects with and/andnot/or. Both
+ * comparisons are made on the unclamped output and the maximum is selected
+ * last, which gives the same result as the if/else-if chain of the scalar
+ * kernel, including for NaN outputs and for limits with min > max.
+ */
+void kernelSSE2(const BankView &b, std::size_t count, const double *setpoints,
+                const double *pvs, double *outputs) {
+  std::size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128d dt = _mm_loadu_pd(b.dt + i);
+    __m128d error =
+        _mm_sub_pd(_mm_loadu_pd(setpoints + i), _mm_loadu_pd(pvs + i));
+
+    __m128d Pout = _mm_mul_pd(_mm_loadu_pd(b.Kp + i), error);
+
+    __m128d integral =
+        _mm_add_pd(_mm_loadu_pd(b.integral + i), _mm_mul_pd(error, dt));
+    _mm_storeu_pd(b.integral + i, integral);
+    __m128d Iout = _mm_mul_pd(_mm_loadu_pd(b.Ki + i), integral);
+
+    __m128d derivative =
+        _mm_mul_pd(_mm_sub_pd(error, _mm_loadu_pd(b.pre_error + i)),
+                   _mm_loadu_pd(b.inv_dt + i));
+    __m128d Dout = _mm_mul_pd(_mm_loadu_pd(b.Kd + i), derivative);
+
+    __m128d output = _mm_add_pd(_mm_add_pd(Pout, Iout), Dout);
+
+    __m128d max = _mm_loadu_pd(b.max + i);
+    __m128d above = _mm_cmpgt_pd(output, max);
+    __m128d min = _mm_loadu_pd(b.min + i);
+    __m128d below = _mm_cmplt_pd(output, min);
+    output = _mm_or_pd(_mm_and_pd(below, min), _mm_andnot_pd(below, output));
+    output = _mm_or_pd(_mm_and_pd(above, max), _mm_andnot_pd(above, output));
+
+    _mm_storeu_pd(b.pre_error + i, error);
+    _mm_storeu_pd(outputs + i, output);
+  }
+  calculateScalar(b, i, count, setpoints, pvs, outputs);
+}
+
+/**
+ * @brief Updates four controllers per iteration with AVX2 instructions.
+ *
+ * @details
+ * Multiplies and adds are kept separate (no FMA) so that every intermediate
+ * result is rounded exactly like in the scalar kernel. The clamp compares the
+ * unclamped output against both limits, as kernelSSE2 does.
+ */
+__attribute__((target("avx2"))) void kernelAVX2(const BankView &b,
+                                                std::size_t count,
+                                                const double *setpoints,
+                                                const double *pvs,
+                                                double *outputs) {
+  std::size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d dt = _mm256_loadu_pd(b.dt + i);
+    __m256d error =
+        _mm256_sub_pd(_mm256_loadu_pd(setpoints + i), _mm256_loadu_pd(pvs + i));
+
+    __m256d Pout = _mm256_mul_pd(_mm256_loadu_pd(b.Kp + i), error);
+
+    __m256d integral = _mm256_add_pd(_mm256_loadu_pd(b.integral + i),
+                                     _mm256_mul_pd(error, dt));
+    _mm256_storeu_pd(b.integral + i, integral);
+    __m256d Iout = _mm256_mul_pd(_mm256_loadu_pd(b.Ki + i), integral);
+
+    __m256d derivative =
+        _mm256_mul_pd(_mm256_sub_pd(error, _mm256_loadu_pd(b.pre_error + i)),
+                      _mm256_loadu_pd(b.inv_dt + i));
+    __m256d Dout = _mm256_mul_pd(_mm256_loadu_pd(b.Kd + i), derivative);
+
+    __m256d output = _mm256_add_pd(_mm256_add_pd(Pout, Iout), Dout);
+
+    __m256d max = _mm256_loadu_pd(b.max + i);
+    __m256d above = _mm256_cmp_pd(output, max, _CMP_GT_OQ);
+    __m256d min = _mm256_loadu_pd(b.min + i);
+    output =
+        _mm256_blendv_pd(output, min, _mm256_cmp_pd(output, min, _CMP_LT_OQ));
+    output = _mm256_blendv_pd(output, max, above);
+
+    _mm256_storeu_pd(b.pre_error + i, error);
+    _mm256_storeu_pd(outputs + i, output);
+  }
+  calculateScalar(b, i, count, setpoints, pvs, outputs);
+}
+
+#endif
+
+/**
+ * @brief Number of per-sample reciprocals computed at once by the variable-dt
+ * path.
+ */
+const std::size_t kInvDtBlock = 256;
+
+/**
+ * @brief Returns the widest kernel supported by the running CPU.
+ */
+PIDBank::Kernel bestKernel() {
+#ifdef PID_BANK_X86_KERNELS
+  if (__builtin_cpu_supports("avx2")) return PIDBank::Kernel::kAVX2;
+  return PIDBank::Kernel::kSSE2;
+#else
+  return PIDBank::Kernel::kScalar;
+#endif
+}
+
+/**
+ * @brief Runs @p kernel on @p count controllers.
+ */
+void runKernel(PIDBank::Kernel kernel, const BankView &view, std::size_t count,
+               const double *setpoints, const double *pvs, double *outputs) {
+  switch (kernel) {
+#ifdef PID_BANK_X86_KERNELS
+    case PIDBank::Kernel::kAVX2:
+      kernelAVX2(view, count, setpoints, pvs, outputs);
+      break;
+    case PIDBank::Kernel::kSSE2:
+      kernelSSE2(view, count, setpoints, pvs, outputs);
+      break;
+#endif
+    default:
+      kernelScalar(view, count, setpoints, pvs, outputs);
+      break;
+  }
+}
+
+/**
+ * @brief Header written by PIDBank::saveState().
+ */
+struct StateHeader {
+  char magic[8];          /**< "PIDSTATE" */
+  std::uint32_t version;  /**< Format version, kStateVersion */
+  std::uint32_t reserved; /**< Zero */
+  std::uint64_t count;    /**< Number of controllers */
+};
+
+const char kStateMagic[8] = {'P', 'I', 'D', 'S', 'T', 'A', 'T', 'E'};
+const std::uint32_t kStateVersion = 1;
+
+}  // namespace
+
+PIDBank::PIDBank() : _kernel(bestKernel()) {}
+
+std::size_t PIDBank::add(double dt, double max, double min, double Kp,
+                         double Kd, double Ki) {
+  _dt.push_back(dt);
+  _inv_dt.push_back(1.0 / dt);
+  _max.push_back(max);
+  _min.push_back(min);
+  _Kp.push_back(Kp);
+  _Kd.push_back(Kd);
+  _Ki.push_back(Ki);
+  _pre_error.push_back(0);
+  _integral.push_back(0);
+  return _dt.size() - 1;
+}
+
+void PIDBank::reserve(std::size_t capacity) {
+  _dt.reserve(capacity);
+  _inv_dt.reserve(capacity);
+  _max.reserve(capacity);
+  _min.reserve(capacity);
+  _Kp.reserve(capacity);
+  _Kd.reserve(capacity);
+  _Ki.reserve(capacity);
+  _pre_error.reserve(capacity);
+  _integral.reserve(capacity);
+}
+
+std::size_t PIDBank::size() const { return _dt.size(); }
+
+void PIDBank::calculate(const double *setpoints, const double *pvs,
+                        double *outputs) {
+  calculate(0, size(), setpoints, pvs, outputs);
+}
+
+void PIDBank::calculate(std::size_t first, std::size_t count,
+                        const double *setpoints, const double *pvs,
+                        double *outputs) {
+  BankView view{_dt.data() + first,        _inv_dt.data() + first,
+                _max.data() + first,       _min.data() + first,
+                _Kp.data() + first,        _Kd.data() + first,
+                _Ki.data() + first,        _pre_error.data() + first,
+                _integral.data() + first};
+  runKernel(_kernel, view, count, setpoints, pvs, outputs);
+}
+
+void PIDBank::calculate(std::size_t first, std::size_t count,
+                        const double *setpoints, const double *pvs,
+                        const double *dts, double *outputs) {
+  // The reciprocals are computed a block at a time into a small buffer, so
+  // the kernels stay division-free and identical to the fixed-dt path.
+  double dt[kInvDtBlock];
+  double inv_dt[kInvDtBlock];
+  std::size_t held[kInvDtBlock];
+  double held_error[kInvDtBlock];
+  for (std::size_t done = 0; done < count; done += kInvDtBlock) {
+    std::size_t n = count - done < kInvDtBlock ? count - done : kInvDtBlock;
+    std::size_t at = first + done;
+
+    // A non-positive dt holds the state, as in BasicPID: with dt and its
+    // reciprocal zeroed the kernel leaves the integral alone and adds no
+    // derivative term, and the previous error is put back afterwards.
+    std::size_t holds = 0;
+    for (std::size_t k = 0; k < n; ++k) {
+      if (dts[done + k] > 0.0) {
+        dt[k] = dts[done + k];
+        inv_dt[k] = 1.0 / dt[k];
+      } else {
+        dt[k] = inv_dt[k] = 0.0;
+        held[holds] = at + k;
+        held_error[holds++] = _pre_error[at + k];
+      }
+    }
+
+    BankView view{dt,                    inv_dt,
+                  _max.data() + at,      _min.data() + at,
+                  _Kp.data() + at,       _Kd.data() + at,
+                  _Ki.data() + at,       _pre_error.data() + at,
+                  _integral.data() + at};
+    runKernel(_kernel, view, n, setpoints + done, pvs + done, outputs + done);
+    for (std::size_t h = 0; h < holds; ++h)
+      _pre_error[held[h]] = held_error[h];
+  }
+}
+
+
+void PIDBank::retune(std::size_t index, double Kp, double Kd, double Ki) {
+  if (Ki != 0.0) _integral[index] = _Ki[index] * _integral[index] / Ki;
+  _Kp[index] = Kp;
+  _Kd[index] = Kd;
+  _Ki[index] = Ki;
+}
+
+void PIDBank::setLimits(std::size_t index, double max, double min) {
+  _max[index] = max;
+  _min[index] = min;
+}
+
+void PIDBank::bumplessTransfer(std::size_t index, double output,
+                               double setpoint, double pv) {
+  double error = setpoint - pv;
+  _pre_error[index] = error;
+  if (_Ki[index] != 0.0)
+    _integral[index] =
+        (output - _Kp[index] * error) / _Ki[index] - error * _dt[index];
+}
+
+PIDState<double> PIDBank::state(std::size_t index) const {
+  return {_integral[index], _pre_error[index], 0.0};
+}
+
+void PIDBank::restore(std::size_t index, const PIDState<double> &state) {
+  _integral[index] = state.integral;
+  _pre_error[index] = state.pre_error;
+}
+
+void PIDBank::saveState(std::ostream &out) const {
+  StateHeader header = {};
+  std::memcpy(header.magic, kStateMagic, sizeof(header.magic));
+  header.version = kStateVersion;
+  header.count = size();
+
+  const std::streamsize bytes =
+      static_cast<std::streamsize>(size() * sizeof(double));
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(_integral.data()), bytes);
+  out.write(reinterpret_cast<const char *>(_pre_error.data()), bytes);
+  if (!out) throw std::runtime_error("cannot write the PIDBank state");
+}
+
+void PIDBank::loadState(std::istream &in) {
+  StateHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, kStateMagic, sizeof(header.magic)) != 0 ||
+      header.version != kStateVersion)
+    throw std::runtime_error("not a PIDBank state");
+  if (header.count != size())
+    throw std::runtime_error("the PIDBank state has a different size");
+
+  // Read into temporaries so that a truncated state leaves the bank intact.
+  const std::streamsize bytes =
+      static_cast<std::streamsize>(size() * sizeof(double));
+  Array integral(size()), pre_error(size());
+  in.read(reinterpret_cast<char *>(integral.data()), bytes);
+  in.read(reinterpret_cast<char *>(pre_error.data()), bytes);
+  if (!in) throw std::runtime_error("the PIDBank state is truncated");
+  _integral.swap(integral);
+  _pre_error.swap(pre_error);
+}
+
+void PIDBank::setKernel(Kernel kernel) {
+  _kernel = (kernel == Kernel::kAuto || !kernelSupported(kernel))
+                ? bestKernel()
+                : kernel;
+}
+
+PIDBank::Kernel PIDBank::kernel() const { return _kernel; }
+
+bool PIDBank::kernelSupported(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::kAuto:
+    case Kernel::kScalar:
+      return true;
+#ifdef PID_BANK_X86_KERNELS
+    case Kernel::kSSE2:
+      return true;
+    case Kernel::kAVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
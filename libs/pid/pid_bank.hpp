@@ -0,0 +1,211 @@
+#ifndef _PID_BANK_H_
+#define _PID_BANK_H_
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "aligned_allocator.hpp"
+#include "basic_pid.hpp"
+
+/**
+ * @brief The PIDBank class stores many PID controllers as a structure of
+ * arrays and updates them in a single batched call.
+ *
+ * Each controller owns the same parameters and state as a PID object (dt, max,
+ * min, Kp, Kd, Ki, the previous error and the integral), but every field is kept
+ * in its own contiguous array. This lets calculate() walk memory linearly and
+ * run the PID formula on several controllers at once with SIMD instructions.
+ *
+ * The results are bit-identical to updating the same controllers one by one
+ * through separate PID objects: every kernel performs the same IEEE-754
+ * operations, in the same order, as BasicPID::calculate.
+ */
+class PIDBank {
+ public:
+  /**
+   * @brief Array type used for every field; each array starts on a cache line.
+   */
+  using Array = std::vector<double, CacheAlignedAllocator<double>>;
+
+  /**
+   * @brief Selects the implementation used by calculate().
+   *
+   * kAuto picks the widest kernel supported by the running CPU. The other
+   * values force a specific kernel, which is mostly useful for testing and
+   * benchmarking.
+   */
+  enum class Kernel { kAuto, kScalar, kSSE2, kAVX2 };
+
+  /**
+   * @brief Constructs an empty bank that uses the automatically selected
+   * kernel.
+   */
+  PIDBank();
+
+  /**
+   * @brief Adds a controller to the bank.
+   *
+   * @param dt  Time interval between control loop updates.
+   * @param max Maximum value of the manipulated variable.
+   * @param min Minimum value of the manipulated variable.
+   * @param Kp  Proportional gain.
+   * @param Kd  Derivative gain.
+   * @param Ki  Integral gain.
+   * @return The index of the new controller.
+   *
+   * @details
+   * The parameters have the same meaning and order as in the PID constructor.
+   * The previous error and the integral of the new controller start at zero.
+   */
+  std::size_t add(double dt, double max, double min, double Kp, double Kd,
+                  double Ki);
+
+  /**
+   * @brief Reserves storage for at least @p capacity controllers, so that
+   * adding them does not reallocate the arrays.
+   */
+  void reserve(std::size_t capacity);
+
+  /**
+   * @brief Returns the number of controllers in the bank.
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Calculates the output of every controller in the bank.
+   *
+   * @param setpoints Array of size() desired values, one per controller.
+   * @param pvs       Array of size() process values, one per controller.
+   * @param outputs   Array of size() values that receives the manipulated
+   * variables.
+   */
+  void calculate(const double *setpoints, const double *pvs, double *outputs);
+
+  /**
+   * @brief Calculates the output of the controllers in the range
+   * [first, first + count).
+   *
+   * @param first     Index of the first controller to update.
+   * @param count     Number of controllers to update.
+   * @param setpoints Array of count desired values; setpoints[0] belongs to
+   * controller @p first.
+   * @param pvs       Array of count process values.
+   * @param outputs   Array of count values that receives the manipulated
+   * variables.
+   */
+  void calculate(std::size_t first, std::size_t count, const double *setpoints,
+                 const double *pvs, double *outputs);
+
+  /**
+   * @brief Calculates the output of the controllers in the range
+   * [first, first + count) for samples with individual time intervals.
+   *
+   * @param first     Index of the first controller to update.
+   * @param count     Number of controllers to update.
+   * @param setpoints Array of count desired values; setpoints[0] belongs to
+   * controller @p first.
+   * @param pvs       Array of count process values.
+   * @param dts       Array of count time intervals since each controller's
+   * previous sample.
+   * @param outputs   Array of count values that receives the manipulated
+   * variables.
+   *
+   * @details
+   * Gives the same results as PID::calculate(setpoint, pv, dt) on each
+   * controller, including for a non-positive dt (a repeated or out-of-order
+   * sample), which holds that controller's integral and previous error. The
+   * reciprocals of @p dts are computed in blocks before the vector kernel
+   * runs, so the kernels themselves never divide.
+   */
+  void calculate(std::size_t first, std::size_t count, const double *setpoints,
+                 const double *pvs, const double *dts, double *outputs);
+
+  /**
+   * @brief Changes the gains of controller @p index, keeping its integral term
+   * continuous as BasicPID::retune() does.
+   *
+   * Like every other member, this must not run concurrently with
+   * calculate(); a controller updated on another thread is retuned through
+   * its owner between two updates.
+   */
+  void retune(std::size_t index, double Kp, double Kd, double Ki);
+
+  /**
+   * @brief Changes the output limits of controller @p index.
+   */
+  void setLimits(std::size_t index, double max, double min);
+
+  /**
+   * @brief Prepares a bumpless switch of controller @p index from manual to
+   * automatic control, as BasicPID::bumplessTransfer() does.
+   */
+  void bumplessTransfer(std::size_t index, double output, double setpoint,
+                        double pv);
+
+  /**
+   * @brief Returns a snapshot of the state of controller @p index.
+   */
+  PIDState<double> state(std::size_t index) const;
+
+  /**
+   * @brief Restores the state of controller @p index.
+   */
+  void restore(std::size_t index, const PIDState<double> &state);
+
+  /**
+   * @brief Writes the state of every controller to @p out.
+   *
+   * The format is a small header followed by the raw integral and previous
+   * error arrays, so saving and loading a large bank is two bulk copies. It
+   * is meant for warm restarts on the same machine: the doubles are stored
+   * in native byte order.
+   *
+   * @throws std::runtime_error if writing fails.
+   */
+  void saveState(std::ostream &out) const;
+
+  /**
+   * @brief Reads a state written by saveState() into the bank.
+   *
+   * The bank must already hold the same number of controllers, with the
+   * parameters they had when the state was saved.
+   *
+   * @throws std::runtime_error if the data is not a state of this bank.
+   */
+  void loadState(std::istream &in);
+
+  /**
+   * @brief Forces the kernel used by calculate().
+   *
+   * @param kernel The kernel to use. Requesting a kernel that the CPU does not
+   * support falls back to kAuto.
+   */
+  void setKernel(Kernel kernel);
+
+  /**
+   * @brief Returns the kernel that calculate() currently runs. Never returns
+   * kAuto.
+   */
+  Kernel kernel() const;
+
+  /**
+   * @brief Checks whether the running CPU and the build support a kernel.
+   */
+  static bool kernelSupported(Kernel kernel);
+
+ private:
+  Array _dt;        /**< Time intervals between updates */
+  Array _inv_dt;    /**< Reciprocals of the time intervals */
+  Array _max;       /**< Maximum output values */
+  Array _min;       /**< Minimum output values */
+  Array _Kp;        /**< Proportional gains */
+  Array _Kd;        /**< Derivative gains */
+  Array _Ki;        /**< Integral gains */
+  Array _pre_error; /**< Previous error values */
+  Array _integral;  /**< Accumulated integrals of the error */
+  Kernel _kernel;   /**< Kernel run by calculate() */
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef _PID_IMPL_H_
+#define _PID_IMPL_H_
+
+#include "basic_pid.hpp"
+
+/**
+ * @brief The PIDImpl class handles the actual PID
+ * (Proportional-Integral-Derivative) control logic.
+ *
+ * This class performs the calculations for the PID controller. It maintains the
+ * internal state, such as the integral of the error and the previous error
+ * value, and applies the PID formula to compute the controller's output.
+ *
+ * The formula itself lives in the header-only BasicPID template; PIDImpl is its
+ * double precision, full PID specialization. The interface is provided by the
+ * PID class, and applications should access this class through the PID class,
+ * ensuring a clear separation of interface and implementation. The declaration
+ * lives in its own header so that the library sources and the benchmarks can
+ * use it directly.
+ */
+
+class PIDImpl : public BasicPID<double> {
+ public:
+  /**
+   * @brief Constructor for PIDImpl.
+   *
+   * @param dt  Time interval between control loop updates.
+   * @param max Maximum value of the manipulated variable (controller output).
+   * @param min Minimum value of the manipulated variable (controller output).
+   * @param Kp  Proportional gain.
+   * @param Kd  Derivative gain.
+   * @param Ki  Integral gain.
+   */
+  using BasicPID<double>::BasicPID;
+};
+
+#endif
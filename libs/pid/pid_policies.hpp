@@ -0,0 +1,122 @@
+#ifndef _PID_POLICIES_H_
+#define _PID_POLICIES_H_
+
+/**
+ * @brief Optional BasicPID features, implemented as policy base classes.
+ *
+ * Every policy has two versions, selected by its `Enabled` parameter. The
+ * enabled one holds the feature's parameters and state. The disabled one is
+ * an empty class whose hooks return their input unchanged. BasicPID inherits
+ * from the version matching its PIDTerms flags and always calls the hooks,
+ * so a disabled feature costs neither cycles nor bytes: the hooks inline to
+ * nothing and the empty bases take no space.
+ */
+
+/**
+ * @brief Setpoint weighting: the P term acts on `b * setpoint - pv` and the D
+ * term on `c * setpoint - pv`.
+ *
+ * Weights below one soften the response to setpoint steps without changing
+ * the response to disturbances. Both weights start at one.
+ */
+template <typename T, bool Enabled>
+class PIDSetpointWeighting {
+ protected:
+  T proportionalError(T setpoint, T pv, T) const { return _b * setpoint - pv; }
+  T derivativeError(T setpoint, T pv, T) const { return _c * setpoint - pv; }
+
+  T _b = T(1); /**< Setpoint weight of the P term */
+  T _c = T(1); /**< Setpoint weight of the D term */
+};
+
+template <typename T>
+class PIDSetpointWeighting<T, false> {
+ protected:
+  static T proportionalError(T, T, T error) { return error; }
+  static T derivativeError(T, T, T error) { return error; }
+};
+
+/**
+ * @brief First-order low-pass filter on the derivative,
+ * `Tf * dD/dt + D = derivative`.
+ *
+ * The filter constant for the nominal dt is computed once; irregular samples
+ * compute it from their own interval. The time constant starts at zero, which
+ * passes the derivative through unchanged.
+ */
+template <typename T, bool Enabled>
+class PIDDerivativeFilter {
+ protected:
+  T filterDerivative(T derivative, T dt, bool nominal) {
+    T a = nominal ? _alpha : _tf / (_tf + dt);
+    _filtered = a * _filtered + (T(1) - a) * derivative;
+    return _filtered;
+  }
+  T filterState() const { return _filtered; }
+  void restoreFilter(T filtered) { _filtered = filtered; }
+
+  T _tf = T(0);       /**< Filter time constant */
+  T _alpha = T(0);    /**< Tf / (Tf + dt) for the nominal dt */
+  T _filtered = T(0); /**< Filtered derivative */
+};
+
+template <typename T>
+class PIDDerivativeFilter<T, false> {
+ protected:
+  static T filterDerivative(T derivative, T, bool) { return derivative; }
+  static T filterState() { return T(0); }
+  static void restoreFilter(T) {}
+};
+
+/**
+ * @brief Derivative on measurement: the D term acts on `-pv` alone.
+ *
+ * The previous measurement is unknown before the first sample, so the first
+ * update takes its own measurement as the previous one instead of zero, and
+ * a non-zero first pv gives no derivative kick. bumplessTransfer() and
+ * restore() supply a previous measurement themselves.
+ */
+template <typename T, bool Enabled>
+class PIDDerivativeOnMeasurement {
+ protected:
+  T previousInput(T input, T previous) {
+    if (_seeded) return previous;
+    _seeded = true;
+    return input;
+  }
+  void seedInput() { _seeded = true; }
+
+  bool _seeded = false; /**< Whether a previous measurement is known */
+};
+
+template <typename T>
+class PIDDerivativeOnMeasurement<T, false> {
+ protected:
+  static T previousInput(T, T previous) { return previous; }
+  static void seedInput() {}
+};
+
+/**
+ * @brief Back-calculation anti-windup: while the output is clamped, the
+ * integral is pulled back by `Kt * (output - unclamped output)`.
+ *
+ * The tracking gain is stored divided by Ki, since the integral is kept in
+ * units of error * time. It starts at Kt = Ki.
+ */
+template <typename T, bool Enabled>
+class PIDBackCalculation {
+ protected:
+  void backCalculate(T &integral, T correction, T dt) const {
+    integral += correction * _tracking * dt;
+  }
+
+  T _tracking = T(1); /**< Kt / Ki */
+};
+
+template <typename T>
+class PIDBackCalculation<T, false> {
+ protected:
+  static void backCalculate(T &, T, T) {}
+};
+
+#endif
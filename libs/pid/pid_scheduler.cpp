@@ -0,0 +1,61 @@
+#include "pid_scheduler.hpp"
+
+PIDScheduler::PIDScheduler(std::size_t threads, std::size_t chunkSize,
+                           bool pinThreads)
+    : _chunk_size((chunkSize + kDoublesPerLine - 1) / kDoublesPerLine *
+                  kDoublesPerLine),
+      _pool(threads, pinThreads),
+      _last_tick(0) {
+  if (_chunk_size == 0) _chunk_size = kDoublesPerLine;
+}
+
+std::size_t PIDScheduler::add(double dt, double max, double min, double Kp,
+                              double Kd, double Ki) {
+  _setpoints.push_back(0);
+  _pvs.push_back(0);
+  _outputs.push_back(0);
+  return _bank.add(dt, max, min, Kp, Kd, Ki);
+}
+
+void PIDScheduler::reserve(std::size_t capacity) {
+  _bank.reserve(capacity);
+  _setpoints.reserve(capacity);
+  _pvs.reserve(capacity);
+  _outputs.reserve(capacity);
+}
+
+std::size_t PIDScheduler::size() const { return _bank.size(); }
+
+std::size_t PIDScheduler::chunkSize() const { return _chunk_size; }
+
+std::size_t PIDScheduler::threads() const { return _pool.threads(); }
+
+double *PIDScheduler::setpoints() { return _setpoints.data(); }
+
+double *PIDScheduler::pvs() { return _pvs.data(); }
+
+const double *PIDScheduler::outputs() const { return _outputs.data(); }
+
+void PIDScheduler::tick() {
+  auto start = std::chrono::steady_clock::now();
+
+  const std::size_t count = size();
+  const std::size_t chunks = (count + _chunk_size - 1) / _chunk_size;
+  _pool.run(chunks, [this, count](std::size_t chunk, std::size_t) {
+    std::size_t first = chunk * _chunk_size;
+    std::size_t n = count - first < _chunk_size ? count - first : _chunk_size;
+    _bank.calculate(first, n, _setpoints.data() + first, _pvs.data() + first,
+                    _outputs.data() + first);
+  });
+
+  _last_tick = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+}
+
+void PIDScheduler::saveState(std::ostream &out) const { _bank.saveState(out); }
+
+void PIDScheduler::loadState(std::istream &in) { _bank.loadState(in); }
+
+std::chrono::nanoseconds PIDScheduler::lastTickTime() const {
+  return _last_tick;
+}
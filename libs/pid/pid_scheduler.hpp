@@ -0,0 +1,93 @@
+#ifndef _PID_SCHEDULER_H_
+#define _PID_SCHEDULER_H_
+
+#include <chrono>
+#include <cstddef>
+
+#include "pid_bank.hpp"
+#include "work_stealing_pool.hpp"
+
+/**
+ * @brief The PIDScheduler class steps a large population of PID controllers
+ * once per control tick on several threads.
+ *
+ * The controllers are stored in a PIDBank and split into chunks of
+ * chunkSize() consecutive controllers. The chunk size is a multiple of a cache
+ * line worth of doubles and every array starts on a cache line, so two threads
+ * never write to the same cache line of `_integral`, `_pre_error` or the
+ * outputs. A tick runs the chunks on a WorkStealingPool.
+ *
+ * Each controller is updated by exactly one thread with the same operations
+ * as a single-threaded PIDBank, so the outputs are identical for any number
+ * of threads.
+ *
+ * Typical use: fill setpoints() and pvs(), call tick(), read outputs().
+ */
+class PIDScheduler {
+ public:
+  /**
+   * @brief Creates an empty scheduler.
+   *
+   * @param threads    Number of threads, including the caller of tick(). Zero
+   * uses one thread per hardware thread.
+   * @param chunkSize  Number of controllers per chunk, rounded up to a whole
+   * number of cache lines.
+   * @param pinThreads Pin each worker thread to its own CPU (Linux only).
+   */
+  explicit PIDScheduler(std::size_t threads = 0, std::size_t chunkSize = 4096,
+                        bool pinThreads = false);
+
+  /**
+   * @brief Adds a controller; the parameters are the same as for PID.
+   *
+   * @return The index of the controller in setpoints(), pvs() and outputs().
+   */
+  std::size_t add(double dt, double max, double min, double Kp, double Kd,
+                  double Ki);
+
+  /**
+   * @brief Reserves storage for at least @p capacity controllers.
+   */
+  void reserve(std::size_t capacity);
+
+  std::size_t size() const;      /**< Number of controllers */
+  std::size_t chunkSize() const; /**< Controllers per chunk */
+  std::size_t threads() const;   /**< Threads used by tick() */
+
+  double *setpoints();           /**< Setpoints for the next tick */
+  double *pvs();                 /**< Process values for the next tick */
+  const double *outputs() const; /**< Outputs of the last tick */
+
+  /**
+   * @brief Updates every controller once, using the current setpoints() and
+   * pvs(), and stores the results in outputs().
+   */
+  void tick();
+
+  /**
+   * @brief Writes the state of every controller; see PIDBank::saveState().
+   */
+  void saveState(std::ostream &out) const;
+
+  /**
+   * @brief Restores a state written by saveState(), e.g. after a restart of
+   * the process; see PIDBank::loadState().
+   */
+  void loadState(std::istream &in);
+
+  /**
+   * @brief Returns the wall time taken by the last call to tick().
+   */
+  std::chrono::nanoseconds lastTickTime() const;
+
+ private:
+  PIDBank _bank;                       /**< State of all controllers */
+  PIDBank::Array _setpoints;           /**< Setpoint of every controller */
+  PIDBank::Array _pvs;                 /**< Process value of every controller */
+  PIDBank::Array _outputs;             /**< Output of every controller */
+  std::size_t _chunk_size;             /**< Controllers per chunk */
+  WorkStealingPool _pool;              /**< Threads that run the chunks */
+  std::chrono::nanoseconds _last_tick; /**< Duration of the last tick */
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "pid_stats.hpp"
+
+#include <limits>
+
+namespace {
+
+/**
+ * @brief Writes @p value as a JSON number that reads back to the same double,
+ * or `null` if it is infinite or NaN, which JSON cannot represent. The
+ * stream's format is left as it was.
+ */
+void writeJsonNumber(std::ostream &out, double value) {
+  if (!std::isfinite(value)) {
+    out << "null";
+    return;
+  }
+  const std::ios_base::fmtflags flags = out.flags(std::ios_base::dec);
+  const std::streamsize precision =
+      out.precision(std::numeric_limits<double>::max_digits10);
+  out << value;
+  out.precision(precision);
+  out.flags(flags);
+}
+
+}  // namespace
+
+constexpr unsigned LatencyHistogram::kSubBucketBits;
+constexpr unsigned LatencyHistogram::kMaxExponent;
+constexpr std::size_t LatencyHistogram::kBuckets;
+
+std::uint64_t LatencyHistogram::percentile(double quantile) const {
+  if (_count == 0) return 0;
+  if (quantile < 0) quantile = 0;
+  if (quantile > 1) quantile = 1;
+
+  // Rank of the wanted value, counting from 1.
+  std::uint64_t rank =
+      static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(_count)));
+  if (rank == 0) rank = 1;
+
+  std::uint64_t seen = 0;
+  for (std::size_t index = 0; index < kBuckets; ++index) {
+    seen += _counts[index];
+    if (seen >= rank) {
+      std::uint64_t upper = bucketUpperBound(index);
+      return upper < _max ? upper : _max;
+    }
+  }
+  return _max;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+  for (std::size_t index = 0; index < kBuckets; ++index)
+    _counts[index] += other._counts[index];
+  _count += other._count;
+  if (other._max > _max) _max = other._max;
+}
+
+void LatencyHistogram::reset() { *this = LatencyHistogram(); }
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index) {
+  const std::size_t linear = std::size_t(1) << kSubBucketBits;
+  if (index < linear) return index;
+  if (index == kBuckets - 1) return UINT64_MAX;
+  // Bucket (shift << bits) + m holds [m << shift, (m + 1) << shift).
+  const std::size_t shift = (index >> kSubBucketBits) - 1;
+  const std::uint64_t m = (index & (linear - 1)) + linear;
+  return ((m + 1) << shift) - 1;
+}
+
+double StatsClock::nanosPerTick() {
+#if PID_STATS_TSC
+  // Thread-safe one-time calibration over about a millisecond.
+  static const double factor = [] {
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t first = ticks();
+    std::chrono::steady_clock::time_point end;
+    do {
+      end = std::chrono::steady_clock::now();
+    } while (end - start < std::chrono::milliseconds(1));
+    std::uint64_t last = ticks();
+    double nanos = std::chrono::duration<double, std::nano>(end - start).count();
+    return last > first ? nanos / static_cast<double>(last - first) : 1.0;
+  }();
+  return factor;
+#else
+  return 1.0;
+#endif
+}
+
+void PIDStatsSnapshot::writeJson(std::ostream &out) const {
+  out << "{\"updates\":" << updates << ",\"saturated_high\":" << saturated_high
+      << ",\"saturated_low\":" << saturated_low << ",\"integral\":";
+  writeJsonNumber(out, integral);
+  out << ",\"integral_peak\":";
+  writeJsonNumber(out, integral_peak);
+  out << ",\"error_mean\":";
+  writeJsonNumber(out, error_mean);
+  out << ",\"error_variance\":";
+  writeJsonNumber(out, error_variance);
+  out << ",\"latency_p50\":" << latency_p50
+      << ",\"latency_p99\":" << latency_p99
+      << ",\"latency_p999\":" << latency_p999
+      << ",\"latency_max\":" << latency_max << "}";
+}
+
+PIDStatsSnapshot PIDStats::snapshot() const {
+  return {_errors.count(),
+          _saturated_high,
+          _saturated_low,
+          _integral,
+          _integral_peak,
+          _errors.mean(),
+          _errors.variance(),
+          _latency.percentile(0.5),
+          _latency.percentile(0.99),
+          _latency.percentile(0.999),
+          _latency.max()};
+}
+
+PIDStats::PIDStats() : _nanos_per_tick(StatsClock::nanosPerTick()) {}
+
+void PIDStats::reset() {
+  const double nanos_per_tick = _nanos_per_tick;
+  *this = PIDStats();
+  _nanos_per_tick = nanos_per_tick;
+}
@@ -0,0 +1,261 @@
+#ifndef _PID_STATS_H_
+#define _PID_STATS_H_
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define PID_STATS_TSC 1
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief The StatsClock class provides the cheap timestamps used to time
+ * calculate().
+ *
+ * On x86-64 it reads the time-stamp counter, which every x86-64 CPU of the
+ * last decade keeps invariant: it ticks at a constant rate across frequency
+ * changes and cores. Ticks are converted to nanoseconds with a factor
+ * calibrated once against std::chrono::steady_clock. Elsewhere it reads
+ * steady_clock directly and a tick is a nanosecond.
+ */
+class StatsClock {
+ public:
+  /**
+   * @brief Returns the current time in ticks.
+   */
+  static std::uint64_t ticks() {
+#if PID_STATS_TSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+  }
+
+  /**
+   * @brief Returns the length of a tick in nanoseconds. The first call
+   * calibrates the counter, which takes about a millisecond.
+   */
+  static double nanosPerTick();
+};
+
+/**
+ * @brief The LatencyHistogram class counts durations in logarithmic buckets
+ * with a bounded relative error, like an HDR histogram.
+ *
+ * Values below 16 have a bucket each. Above that, every power of two is
+ * split into 16 equal sub-buckets, so a bucket is at most 1/16 (6.25%) of
+ * its lower bound wide. Values from 2^32 up are counted in the last bucket.
+ * Recording is a count-leading-zeros, a shift and an increment.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr unsigned kSubBucketBits = 4;  /**< log2(sub-buckets) */
+  static constexpr unsigned kMaxExponent = 32;   /**< Values up to 2^32 */
+  static constexpr std::size_t kBuckets =
+      ((kMaxExponent - kSubBucketBits + 1) << kSubBucketBits) + 1; /**< Count */
+
+  /**
+   * @brief Counts one value.
+   */
+  void record(std::uint64_t value) {
+    ++_counts[bucket(value)];
+    ++_count;
+    if (value > _max) _max = value;
+  }
+
+  std::uint64_t count() const { return _count; } /**< Values recorded */
+  std::uint64_t max() const { return _max; }     /**< Largest value, exact */
+
+  /**
+   * @brief Returns the value below which a fraction @p quantile of the
+   * recorded values fall, as the upper bound of its bucket, or zero when the
+   * histogram is empty.
+   *
+   * @param quantile Quantile in [0, 1], e.g. 0.99.
+   */
+  std::uint64_t percentile(double quantile) const;
+
+  /**
+   * @brief Adds the counts of @p other, e.g. to combine per-thread histograms.
+   */
+  void merge(const LatencyHistogram &other);
+
+  /**
+   * @brief Forgets every recorded value.
+   */
+  void reset();
+
+  /**
+   * @brief Returns the bucket of @p value.
+   */
+  static std::size_t bucket(std::uint64_t value) {
+    const std::uint64_t linear = std::uint64_t(1) << kSubBucketBits;
+    if (value < linear) return static_cast<std::size_t>(value);
+    if (value >> kMaxExponent) return kBuckets - 1;
+    const unsigned exponent = 63u - static_cast<unsigned>(__builtin_clzll(value));
+    const unsigned shift = exponent - kSubBucketBits;
+    return (static_cast<std::size_t>(shift) << kSubBucketBits) +
+           static_cast<std::size_t>(value >> shift);
+  }
+
+  /**
+   * @brief Returns the largest value counted in bucket @p index.
+   */
+  static std::uint64_t bucketUpperBound(std::size_t index);
+
+ private:
+  std::array<std::uint64_t, kBuckets> _counts{}; /**< Count per bucket */
+  std::uint64_t _count = 0;                      /**< Total count */
+  std::uint64_t _max = 0;                        /**< Largest value */
+};
+
+/**
+ * @brief The RunningStats class keeps the mean and variance of a stream of
+ * values with Welford's algorithm, which is numerically stable and needs no
+ * storage per value.
+ */
+class RunningStats {
+ public:
+  /**
+   * @brief Adds one value.
+   */
+  void add(double value) {
+    ++_count;
+    const double delta = value - _mean;
+    _mean += delta / static_cast<double>(_count);
+    _m2 += delta * (value - _mean);
+  }
+
+  std::uint64_t count() const { return _count; } /**< Values added */
+  double mean() const { return _mean; }          /**< Mean, 0 if empty */
+
+  /**
+   * @brief Returns the population variance, or zero with fewer than two
+   * values.
+   */
+  double variance() const {
+    return _count > 1 ? _m2 / static_cast<double>(_count) : 0.0;
+  }
+
+  /**
+   * @brief Forgets every value.
+   */
+  void reset() { *this = RunningStats(); }
+
+ private:
+  std::uint64_t _count = 0; /**< Number of values */
+  double _mean = 0;         /**< Running mean */
+  double _m2 = 0;           /**< Sum of squared deviations from the mean */
+};
+
+/**
+ * @brief Copy of the statistics of one controller, as returned by
+ * PIDStats::snapshot().
+ */
+struct PIDStatsSnapshot {
+  std::uint64_t updates;        /**< Number of calculate() calls */
+  std::uint64_t saturated_high; /**< Outputs clamped at max */
+  std::uint64_t saturated_low;  /**< Outputs clamped at min */
+  double integral;              /**< Integral after the last update */
+  double integral_peak;         /**< Largest |integral| seen */
+  double error_mean;            /**< Mean of setpoint - pv */
+  double error_variance;        /**< Population variance of the error */
+  std::uint64_t latency_p50;    /**< Median calculate() time, ns */
+  std::uint64_t latency_p99;    /**< 99th percentile, ns */
+  std::uint64_t latency_p999;   /**< 99.9th percentile, ns */
+  std::uint64_t latency_max;    /**< Slowest calculate(), ns */
+
+  /**
+   * @brief Writes the snapshot as one JSON object. Doubles are written with
+   * enough digits to read back exactly; infinite and NaN values, e.g. of a
+   * diverged controller, are written as null.
+   */
+  void writeJson(std::ostream &out) const;
+};
+
+/**
+ * @brief The PIDStats class collects what a running controller does:
+ * saturation counts, the size of the integral, error statistics and a
+ * latency histogram.
+ *
+ * A PID fills it once per calculate() after setStats(), timing the call
+ * with two StatsClock reads. A PIDStats is not
+ * synchronized: it is written by the thread running its controller, and
+ * snapshot() or reset() must be called from that thread too, or while the
+ * controller is not running. A few controllers updated by the same thread
+ * may share one PIDStats to aggregate them.
+ *
+ * Overhead budget, checked by the pid-bench benchmarks: a PID without stats
+ * pays one predictable branch, under 1 ns (BM_PID_Calculate). With stats,
+ * each calculate() adds two StatsClock reads plus at most 20 ns of
+ * bookkeeping, mostly the division in the running mean (BM_PIDStats_Record,
+ * BM_PID_CalculateWithStats). snapshot() scans the histogram three times and
+ * stays below 1 us (BM_PIDStats_Snapshot).
+ */
+class PIDStats {
+ public:
+  /**
+   * @brief Creates empty statistics; calibrates the StatsClock if needed.
+   */
+  PIDStats();
+
+  /**
+   * @brief Converts a duration measured with StatsClock to nanoseconds.
+   */
+  std::uint64_t toNanos(std::uint64_t ticks) const {
+    return static_cast<std::uint64_t>(static_cast<double>(ticks) *
+                                      _nanos_per_tick);
+  }
+
+  /**
+   * @brief Records one update.
+   *
+   * @param error    setpoint - pv of the update.
+   * @param output   Output returned by the controller.
+   * @param max      Upper output limit of the controller.
+   * @param min      Lower output limit of the controller.
+   * @param integral Integral after the update.
+   * @param nanos    Duration of the update.
+   */
+  void record(double error, double output, double max, double min,
+              double integral, std::uint64_t nanos) {
+    _saturated_high += output >= max;
+    _saturated_low += output <= min;
+    _integral = integral;
+    const double magnitude = std::fabs(integral);
+    if (magnitude > _integral_peak) _integral_peak = magnitude;
+    _errors.add(error);
+    _latency.record(nanos);
+  }
+
+  /**
+   * @brief Returns a copy of the current statistics.
+   */
+  PIDStatsSnapshot snapshot() const;
+
+  /**
+   * @brief Clears every statistic.
+   */
+  void reset();
+
+  const RunningStats &errors() const { return _errors; } /**< Error stats */
+  const LatencyHistogram &latency() const { return _latency; } /**< Times */
+
+ private:
+  std::uint64_t _saturated_high = 0; /**< Outputs at max */
+  std::uint64_t _saturated_low = 0;  /**< Outputs at min */
+  double _integral = 0;              /**< Latest integral */
+  double _integral_peak = 0;         /**< Largest |integral| */
+  RunningStats _errors;              /**< Error mean and variance */
+  LatencyHistogram _latency;         /**< calculate() durations */
+  double _nanos_per_tick;            /**< StatsClock tick length */
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef _PID_TUNING_H_
+#define _PID_TUNING_H_
+
+#include "seqlock.hpp"
+
+/**
+ * @brief Gains and output limits of a controller, in the order of the PID
+ * constructor.
+ */
+struct PIDParameters {
+  double max; /**< Maximum value of the manipulated variable */
+  double min; /**< Minimum value of the manipulated variable */
+  double Kp;  /**< Proportional gain */
+  double Kd;  /**< Derivative gain */
+  double Ki;  /**< Integral gain */
+};
+
+/**
+ * @brief Parameters published by a control-plane thread and picked up by the
+ * PIDs attached to it with PID::setTuning().
+ *
+ * store() may be called from any thread while the controllers keep running;
+ * each attached PID applies the new parameters at its next calculate().
+ */
+using PIDTuning = SeqLock<PIDParameters>;
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef _PID_VARIANTS_H_
+#define _PID_VARIANTS_H_
+
+#include "basic_pid.hpp"
+#include "fixed_point.hpp"
+
+/**
+ * @brief Single precision controller: 36 bytes per loop instead of 72.
+ *
+ * Error bound: every operation rounds to a relative 2^-24. One update from
+ * the same state as a BasicPID<double> differs from it by about
+ * 2^-24 * (4 * (|P| + |I| + |D|) + (|Kp| + 2 |Kd| / dt) * (|setpoint| + |pv|)).
+ * The second part comes from the rounding of the error, which the derivative
+ * amplifies by 1 / dt, so it dominates for small dt. In a stable closed loop
+ * the feedback keeps the difference from accumulating.
+ */
+using FloatPID = BasicPID<float>;
+
+/**
+ * @brief Q16.16 fixed-point controller: 36 bytes per loop, integer
+ * arithmetic only, saturating at about +/-32768.
+ *
+ * Error bound, with q = 2^-16: the parameters, inputs and state are rounded
+ * to q / 2 and every product to q / 2. One update from the same state as a
+ * BasicPID<double> differs from it by about
+ * q * (|Kp| + |e| + |Ki| (1 + dt + |e| + |I|)
+ *      + |Kd| (2 / dt + |de| (1 + 1 / (2 dt^2))) + |de| / dt + 3),
+ * where e is the error, I the integral and de the change of the error. The
+ * |Kd| terms dominate for small dt: choose dt and Kd so that
+ * |Kd| / dt^2 stays well below 1 / q. Values outside the range, including
+ * 1 / dt, saturate instead of wrapping.
+ */
+using FixedPID = BasicPID<Q16_16>;
+
+#endif
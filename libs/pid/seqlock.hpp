@@ -0,0 +1,104 @@
+#ifndef _SEQLOCK_H_
+#define _SEQLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "aligned_allocator.hpp"
+
+/**
+ * @brief The SeqLock class shares a small value between threads without
+ * ever blocking its readers.
+ *
+ * A writer makes the sequence number odd, copies the value in and makes the
+ * sequence even again. A reader copies the value out and retries if the
+ * sequence was odd or changed in the meantime, so it never waits on a lock
+ * and a writer never waits on readers. Writers are serialized by a
+ * compare-and-swap on the sequence, so any number of threads may store().
+ *
+ * The value is kept as 64-bit atomic words accessed with relaxed ordering,
+ * which makes the concurrent copies well-defined. The SeqLock starts on a
+ * cache line, and a value of up to 56 bytes shares that line with the
+ * sequence, so a reader usually fetches both with a single miss.
+ *
+ * @tparam T A trivially copyable type.
+ */
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "a SeqLock value must be trivially copyable");
+
+ public:
+  /**
+   * @brief Creates a lock holding @p value.
+   */
+  explicit SeqLock(const T &value = T()) {
+    std::uint64_t words[kWords] = {};
+    std::memcpy(words, &value, sizeof(T));
+    for (std::size_t n = 0; n < kWords; ++n)
+      _words[n].store(words[n], std::memory_order_relaxed);
+  }
+
+  SeqLock(const SeqLock &) = delete;
+  SeqLock &operator=(const SeqLock &) = delete;
+
+  /**
+   * @brief Replaces the value. Lock-free; waits only for other writers.
+   */
+  void store(const T &value) {
+    std::uint64_t words[kWords] = {};
+    std::memcpy(words, &value, sizeof(T));
+
+    std::uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+    do {
+      while (sequence & 1)
+        sequence = _sequence.load(std::memory_order_relaxed);
+    } while (!_sequence.compare_exchange_weak(sequence, sequence + 1,
+                                              std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t n = 0; n < kWords; ++n)
+      _words[n].store(words[n], std::memory_order_relaxed);
+    _sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Returns a consistent copy of the value.
+   *
+   * @param version If not null, receives the version() of the copy.
+   */
+  T load(std::uint64_t *version = nullptr) const {
+    std::uint64_t words[kWords];
+    std::uint64_t before, after;
+    do {
+      before = _sequence.load(std::memory_order_acquire);
+      for (std::size_t n = 0; n < kWords; ++n)
+        words[n] = _words[n].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = _sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    if (version != nullptr) *version = before;
+    T value;
+    std::memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+  /**
+   * @brief Returns a number that changes with every store(). Reading it is
+   * a single atomic load, cheap enough to poll on a hot path.
+   */
+  std::uint64_t version() const {
+    return _sequence.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr std::size_t kWords =
+      (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> _sequence{0};
+  std::atomic<std::uint64_t> _words[kWords]; /**< The value */
+};
+
+#endif
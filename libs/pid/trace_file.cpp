@@ -0,0 +1,195 @@
+#include "trace_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+
+const char kTraceMagic[8] = {'P', 'I', 'D', 'T', 'R', 'A', 'C', 'E'};
+
+/**
+ * @brief Number of records the writer moves from the ring per iteration.
+ */
+const std::size_t kDrainBatch = 4096;
+
+/**
+ * @brief Throws a std::system_error for the current errno.
+ */
+[[noreturn]] void throwErrno(const std::string &what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+}  // namespace
+
+TraceWriter::TraceWriter(TraceRing &ring, const std::string &path,
+                         std::size_t growBytes)
+    : _ring(ring),
+      _grow_bytes(growBytes < kDrainBatch * sizeof(TraceRecord)
+                      ? kDrainBatch * sizeof(TraceRecord)
+                      : growBytes),
+      _fd(-1),
+      _map(nullptr),
+      _mapped(0),
+      _count(0),
+      _lost(0),
+      _stop(false) {
+  _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (_fd < 0) throwErrno("cannot create trace file " + path);
+  if (!reserve(sizeof(TraceFileHeader))) {
+    ::close(_fd);
+    throwErrno("cannot map trace file " + path);
+  }
+
+  TraceFileHeader header;
+  std::memset(&header, 0, sizeof header);
+  std::memcpy(header.magic, kTraceMagic, sizeof header.magic);
+  header.version = kTraceFileVersion;
+  header.record_size = sizeof(TraceRecord);
+  std::memcpy(_map, &header, sizeof header);
+
+  _thread = std::thread(&TraceWriter::run, this);
+}
+
+TraceWriter::~TraceWriter() { stop(); }
+
+void TraceWriter::stop() {
+  if (!_thread.joinable()) return;
+  _stop.store(true, std::memory_order_release);
+  _thread.join();
+
+  std::uint64_t count = _count.load(std::memory_order_relaxed);
+  std::size_t bytes = sizeof(TraceFileHeader) + count * sizeof(TraceRecord);
+  if (_map != nullptr) {
+    TraceFileHeader *header = reinterpret_cast<TraceFileHeader *>(_map);
+    header->count = count;
+    header->dropped = dropped();
+    ::munmap(_map, _mapped);
+    _map = nullptr;
+  }
+  if (::ftruncate(_fd, static_cast<off_t>(bytes)) != 0) {
+    // The header already holds the record count, so the trailing space is
+    // harmless; readers ignore it.
+  }
+  ::close(_fd);
+  _fd = -1;
+}
+
+std::uint64_t TraceWriter::written() const {
+  return _count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t TraceWriter::dropped() const {
+  return _ring.dropped() + _lost.load(std::memory_order_relaxed);
+}
+
+void TraceWriter::run() {
+  while (!_stop.load(std::memory_order_acquire)) {
+    if (drain() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  // Records pushed before stop() was called are still in the ring.
+  while (drain() != 0) {
+  }
+}
+
+std::size_t TraceWriter::drain() {
+  std::uint64_t count = _count.load(std::memory_order_relaxed);
+  std::size_t offset = sizeof(TraceFileHeader) + count * sizeof(TraceRecord);
+  std::size_t room = kDrainBatch;
+  if (!reserve(offset + kDrainBatch * sizeof(TraceRecord)))
+    room = (_mapped - offset) / sizeof(TraceRecord);
+
+  if (room == 0) {
+    // The file cannot grow: keep what is on disk and count the rest as lost,
+    // so the ring keeps accepting records and stop() still finishes.
+    _discard.resize(kDrainBatch);
+    std::size_t n = _ring.pop(_discard.data(), kDrainBatch);
+    _lost.fetch_add(n, std::memory_order_relaxed);
+    return n;
+  }
+
+  std::size_t n =
+      _ring.pop(reinterpret_cast<TraceRecord *>(_map + offset), room);
+  _count.store(count + n, std::memory_order_relaxed);
+  return n;
+}
+
+bool TraceWriter::reserve(std::size_t bytes) {
+  if (bytes <= _mapped && _map != nullptr) return true;
+
+  std::size_t size = _mapped + _grow_bytes;
+  if (size < bytes) size = bytes;
+
+  // The old mapping stays valid until the new one exists, so a failure leaves
+  // every record written so far in place.
+  if (::ftruncate(_fd, static_cast<off_t>(size)) != 0) return false;
+  void *map =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (map == MAP_FAILED) return false;
+  if (_map != nullptr) ::munmap(_map, _mapped);
+  _map = static_cast<char *>(map);
+  _mapped = size;
+  return true;
+}
+
+TraceReader::TraceReader(const std::string &path) : _map(nullptr), _length(0) {
+  _fd = ::open(path.c_str(), O_RDONLY);
+  if (_fd < 0) throwErrno("cannot open trace file " + path);
+
+  struct stat st;
+  if (::fstat(_fd, &st) != 0) {
+    ::close(_fd);
+    throwErrno("cannot stat trace file " + path);
+  }
+  _length = static_cast<std::size_t>(st.st_size);
+  if (_length < sizeof(TraceFileHeader)) {
+    ::close(_fd);
+    throw std::runtime_error(path + " is too short to be a trace file");
+  }
+
+  void *map = ::mmap(nullptr, _length, PROT_READ, MAP_PRIVATE, _fd, 0);
+  if (map == MAP_FAILED) {
+    ::close(_fd);
+    throwErrno("cannot map trace file " + path);
+  }
+  _map = static_cast<const char *>(map);
+  ::madvise(map, _length, MADV_SEQUENTIAL);
+
+  const TraceFileHeader &h = header();
+  if (std::memcmp(h.magic, kTraceMagic, sizeof h.magic) != 0 ||
+      h.version != kTraceFileVersion ||
+      h.record_size != sizeof(TraceRecord) ||
+      h.count > (_length - sizeof(TraceFileHeader)) / sizeof(TraceRecord)) {
+    ::munmap(map, _length);
+    ::close(_fd);
+    throw std::runtime_error(path + " is not a valid trace file");
+  }
+}
+
+TraceReader::~TraceReader() {
+  ::munmap(const_cast<char *>(_map), _length);
+  ::close(_fd);
+}
+
+const TraceFileHeader &TraceReader::header() const {
+  return *reinterpret_cast<const TraceFileHeader *>(_map);
+}
+
+std::uint64_t TraceReader::size() const { return header().count; }
+
+const TraceRecord *TraceReader::begin() const {
+  return reinterpret_cast<const TraceRecord *>(_map + sizeof(TraceFileHeader));
+}
+
+const TraceRecord *TraceReader::end() const { return begin() + size(); }
+
+const TraceRecord &TraceReader::operator[](std::uint64_t index) const {
+  return begin()[index];
+}
@@ -0,0 +1,143 @@
+#ifndef _TRACE_FILE_H_
+#define _TRACE_FILE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace_ring.hpp"
+
+/**
+ * @brief Header at the start of every trace file.
+ *
+ * A trace file is this 64-byte header followed by `count` TraceRecord
+ * structures, all in the native byte order of the machine that wrote it.
+ */
+struct TraceFileHeader {
+  char magic[8];              /**< "PIDTRACE" */
+  std::uint32_t version;      /**< kTraceFileVersion */
+  std::uint32_t record_size;  /**< sizeof(TraceRecord) */
+  std::uint64_t count;        /**< Number of records after the header */
+  std::uint64_t dropped;      /**< Records the ring had to drop */
+  std::uint8_t reserved[32];  /**< Zero */
+};
+
+static_assert(sizeof(TraceFileHeader) == 64,
+              "TraceFileHeader is part of the trace file format");
+
+/**
+ * @brief Version written to and expected in TraceFileHeader::version.
+ */
+constexpr std::uint32_t kTraceFileVersion = 2;
+
+/**
+ * @brief The TraceWriter class drains a TraceRing to a memory-mapped trace file
+ * on a background thread.
+ *
+ * The file is grown in steps of `growBytes` and written through a shared
+ * mapping, so flushing a record is a plain memory copy. stop() (or the
+ * destructor) drains the ring, writes the header and truncates the file to its
+ * exact size. If the file cannot be grown, the records already on disk are
+ * kept and later ones are discarded and counted in TraceFileHeader::dropped.
+ */
+class TraceWriter {
+ public:
+  /**
+   * @brief Creates (or truncates) @p path and starts the writer thread.
+   *
+   * @param ring      Ring to drain; must outlive the writer.
+   * @param path      Path of the trace file.
+   * @param growBytes Number of bytes the file is extended by when full.
+   *
+   * @throws std::system_error if the file cannot be created or mapped.
+   */
+  TraceWriter(TraceRing &ring, const std::string &path,
+              std::size_t growBytes = 64 << 20);
+
+  /**
+   * @brief Calls stop().
+   */
+  ~TraceWriter();
+
+  TraceWriter(const TraceWriter &) = delete;
+  TraceWriter &operator=(const TraceWriter &) = delete;
+
+  /**
+   * @brief Writes every record still in the ring, finalizes the file and stops
+   * the writer thread. Further calls do nothing.
+   */
+  void stop();
+
+  /**
+   * @brief Returns the number of records written so far.
+   */
+  std::uint64_t written() const;
+
+  /**
+   * @brief Returns the number of records lost so far, either because the ring
+   * was full or because the file could not be grown.
+   */
+  std::uint64_t dropped() const;
+
+ private:
+  void run();
+  std::size_t drain();
+  bool reserve(std::size_t bytes);
+
+  TraceRing &_ring;
+  std::size_t _grow_bytes;            /**< Growth step of the file */
+  int _fd;                            /**< Trace file descriptor */
+  char *_map;                         /**< Mapping of the whole file */
+  std::size_t _mapped;                /**< Size of the file and mapping */
+  std::atomic<std::uint64_t> _count;  /**< Records written */
+  std::atomic<std::uint64_t> _lost;   /**< Records discarded, file full */
+  std::vector<TraceRecord> _discard;  /**< Sink for discarded records */
+  std::atomic<bool> _stop;            /**< Asks the thread to finish */
+  std::thread _thread;                /**< Writer thread */
+};
+
+/**
+ * @brief The TraceReader class maps a trace file read-only and exposes its
+ * records as an array.
+ *
+ * Pages are loaded on demand by the operating system, so traces much larger
+ * than the available memory can be scanned at full speed.
+ */
+class TraceReader {
+ public:
+  /**
+   * @brief Opens and maps @p path.
+   *
+   * @throws std::system_error if the file cannot be opened or mapped.
+   * @throws std::runtime_error if the file is not a valid trace.
+   */
+  explicit TraceReader(const std::string &path);
+
+  /**
+   * @brief Unmaps the file.
+   */
+  ~TraceReader();
+
+  TraceReader(const TraceReader &) = delete;
+  TraceReader &operator=(const TraceReader &) = delete;
+
+  const TraceFileHeader &header() const; /**< Header of the file */
+  std::uint64_t size() const;            /**< Number of records */
+  const TraceRecord *begin() const;      /**< First record */
+  const TraceRecord *end() const;        /**< One past the last record */
+
+  /**
+   * @brief Returns record @p index, which must be less than size().
+   */
+  const TraceRecord &operator[](std::uint64_t index) const;
+
+ private:
+  int _fd;             /**< Trace file descriptor */
+  const char *_map;    /**< Mapping of the whole file */
+  std::size_t _length; /**< Size of the mapping */
+};
+
+#endif
@@ -0,0 +1,12 @@
+#include "trace_replay.hpp"
+
+TraceReplayer::TraceReplayer(const PID &prototype) : _prototype(prototype) {}
+
+double TraceReplayer::replay(const TraceRecord &record) {
+  PID &pid = _pids.emplace(record.controller, _prototype).first->second;
+  return (record.flags & kTraceExplicitDt) != 0
+             ? pid.calculate(record.setpoint, record.pv, record.dt)
+             : pid.calculate(record.setpoint, record.pv);
+}
+
+std::size_t TraceReplayer::controllers() const { return _pids.size(); }
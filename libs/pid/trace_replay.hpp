@@ -0,0 +1,40 @@
+#ifndef _TRACE_REPLAY_H_
+#define _TRACE_REPLAY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "pid.hpp"
+#include "trace_ring.hpp"
+
+/**
+ * @brief The TraceReplayer class feeds trace records back through fresh PID
+ * objects, one per controller id seen in the trace.
+ *
+ * Every controller starts as a copy of the prototype. Controllers are keyed by
+ * id, so sparse ids, up to the largest 32-bit value, only cost the controllers
+ * that actually appear. Records of variable-dt updates are replayed with the
+ * dt they recorded.
+ */
+class TraceReplayer {
+ public:
+  /**
+   * @param prototype Gains, limits and initial state of every controller.
+   */
+  explicit TraceReplayer(const PID &prototype);
+
+  /**
+   * @brief Replays @p record on its controller and returns the output, to be
+   * compared with TraceRecord::output.
+   */
+  double replay(const TraceRecord &record);
+
+  std::size_t controllers() const; /**< Number of controllers seen so far */
+
+ private:
+  PID _prototype;                                /**< Initial controller */
+  std::unordered_map<std::uint32_t, PID> _pids;  /**< Controllers by id */
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef _TRACE_RING_H_
+#define _TRACE_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "aligned_allocator.hpp"
+
+/**
+ * @brief One traced PID update: the inputs, the output and the contribution of
+ * each term.
+ *
+ * The record is exactly one cache line long and is stored unchanged in trace
+ * files, so its layout is part of the file format. Records keep the order in
+ * which they were pushed, so the position of a record in its ring or file is
+ * its sequence number.
+ */
+struct TraceRecord {
+  std::uint32_t controller; /**< Id given to PID::setTracer() */
+  std::uint32_t flags;      /**< kTraceExplicitDt or zero */
+  double setpoint;          /**< Desired value passed to calculate() */
+  double pv;                /**< Process value passed to calculate() */
+  double dt;                /**< Interval the update used */
+  double output;            /**< Value returned by calculate() */
+  double p;                 /**< Proportional contribution */
+  double i;                 /**< Integral contribution */
+  double d;                 /**< Derivative contribution */
+};
+
+static_assert(sizeof(TraceRecord) == 64,
+              "TraceRecord is part of the trace file format");
+
+/**
+ * @brief Set in TraceRecord::flags when the update was given its dt, through
+ * calculate(setpoint, pv, dt) or calculateAt(). Replaying such a record must
+ * pass TraceRecord::dt; other records used the controller's fixed dt.
+ */
+constexpr std::uint32_t kTraceExplicitDt = 1;
+
+/**
+ * @brief The TraceRing class is a lock-free single-producer, single-consumer
+ * ring buffer of TraceRecord.
+ *
+ * The control thread pushes records with tryPush(), which never blocks and
+ * never allocates: when the ring is full the record is dropped and counted.
+ * A TraceWriter pops them on a background thread. All controllers that share
+ * a ring must therefore be updated from the same thread.
+ */
+class TraceRing {
+ public:
+  /**
+   * @brief Creates a ring holding @p capacity records, rounded up to a power of
+   * two.
+   */
+  explicit TraceRing(std::size_t capacity) : _head(0), _tail(0), _dropped(0) {
+    std::size_t size = 1;
+    while (size < capacity) size <<= 1;
+    _records.resize(size);
+    _mask = size - 1;
+  }
+
+  TraceRing(const TraceRing &) = delete;
+  TraceRing &operator=(const TraceRing &) = delete;
+
+  /**
+   * @brief Appends a record. Producer thread only.
+   *
+   * @param record The record to append.
+   * @return False if the ring was full and the record was dropped.
+   */
+  bool tryPush(const TraceRecord &record) {
+    std::uint64_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) > _mask) {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    _records[head & _mask] = record;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Removes up to @p max records in order. Consumer thread only.
+   *
+   * @param out Array that receives the records.
+   * @param max Capacity of @p out.
+   * @return The number of records copied to @p out.
+   */
+  std::size_t pop(TraceRecord *out, std::size_t max) {
+    std::uint64_t tail = _tail.load(std::memory_order_relaxed);
+    std::uint64_t available = _head.load(std::memory_order_acquire) - tail;
+    std::size_t n = available < max ? static_cast<std::size_t>(available) : max;
+    for (std::size_t k = 0; k < n; ++k) out[k] = _records[(tail + k) & _mask];
+    _tail.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  /**
+   * @brief Returns the number of records dropped because the ring was full.
+   */
+  std::uint64_t dropped() const {
+    return _dropped.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::vector<TraceRecord, CacheAlignedAllocator<TraceRecord>> _records;
+  std::size_t _mask; /**< Capacity minus one */
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> _head; /**< Next push */
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> _tail; /**< Next pop */
+  alignas(kCacheLineSize) std::atomic<std::uint64_t> _dropped;
+};
+
+#endif
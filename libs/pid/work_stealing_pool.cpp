@@ -0,0 +1,128 @@
+#include "work_stealing_pool.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Replaces a thread count of zero by the number of hardware threads.
+ */
+std::size_t resolveThreads(std::size_t threads) {
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+  return threads == 0 ? 1 : threads;
+}
+
+#ifdef __linux__
+/**
+ * @brief Returns the CPUs the process may run on, honouring taskset and
+ * cpuset restrictions.
+ */
+std::vector<int> allowedCpus() {
+  std::vector<int> cpus;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) return cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+  return cpus;
+}
+#endif
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t threads, bool pinThreads)
+    : _ranges(resolveThreads(threads)) {
+  threads = _ranges.size();
+  _threads.reserve(threads - 1);
+  for (std::size_t t = 1; t < threads; ++t)
+    _threads.emplace_back(&WorkStealingPool::workerLoop, this, t);
+
+#ifdef __linux__
+  if (!pinThreads) return;
+  const std::vector<int> cpus = allowedCpus();
+  if (cpus.empty()) return;
+  for (std::size_t t = 1; t < threads; ++t) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[t % cpus.size()], &set);
+    if (pthread_setaffinity_np(_threads[t - 1].native_handle(), sizeof(set),
+                               &set) == 0)
+      ++_pinned;
+  }
+#else
+  (void)pinThreads;
+#endif
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _start.notify_all();
+  for (std::thread &thread : _threads) thread.join();
+}
+
+std::size_t WorkStealingPool::threads() const { return _ranges.size(); }
+
+std::size_t WorkStealingPool::pinnedThreads() const { return _pinned; }
+
+void WorkStealingPool::run(std::size_t tasks, const Task &task) {
+  if (tasks == 0) return;
+
+  const std::size_t n = threads();
+  for (std::size_t t = 0; t < n; ++t) {
+    _ranges[t].next.store(tasks * t / n, std::memory_order_relaxed);
+    _ranges[t].end = tasks * (t + 1) / n;
+  }
+
+  // Publishing the batch under the mutex also publishes the ranges.
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _task = &task;
+    _active = _threads.size();
+    ++_generation;
+  }
+  _start.notify_all();
+
+  work(0, task);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _finished.wait(lock, [this] { return _active == 0; });
+  _task = nullptr;
+}
+
+void WorkStealingPool::workerLoop(std::size_t thread) {
+  std::size_t seen = 0;
+  for (;;) {
+    const Task *task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _start.wait(lock, [&] { return _stop || _generation != seen; });
+      if (_stop) return;
+      seen = _generation;
+      task = _task;
+    }
+
+    work(thread, *task);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--_active == 0) _finished.notify_one();
+  }
+}
+
+void WorkStealingPool::work(std::size_t thread, const Task &task) {
+  // Visit the own range first, then steal from the following threads.
+  const std::size_t n = threads();
+  for (std::size_t k = 0; k < n; ++k) {
+    Range &range = _ranges[(thread + k) % n];
+    for (;;) {
+      std::size_t i = range.next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= range.end) break;
+      task(i, thread);
+    }
+  }
+}
@@ -0,0 +1,99 @@
+#ifndef _WORK_STEALING_POOL_H_
+#define _WORK_STEALING_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "aligned_allocator.hpp"
+
+/**
+ * @brief The WorkStealingPool class runs batches of indexed tasks on a fixed
+ * set of threads.
+ *
+ * A call to run() splits the task indices [0, tasks) into one contiguous range
+ * per thread. Each thread first drains its own range, then steals the
+ * remaining indices of the other threads, so a thread that finishes early
+ * helps the slow ones instead of idling. The calling thread takes part as
+ * thread 0, so a pool of N threads starts N - 1 background threads.
+ *
+ * Every range lives on its own cache line, so claiming an index only touches
+ * memory shared with the threads working on the same range.
+ */
+class WorkStealingPool {
+ public:
+  /**
+   * @brief Function run for every task: the task index and the index of the
+   * thread running it, in [0, threads()).
+   */
+  using Task = std::function<void(std::size_t task, std::size_t thread)>;
+
+  /**
+   * @brief Starts the pool.
+   *
+   * @param threads    Number of threads, including the caller of run(). Zero
+   * uses one thread per hardware thread.
+   * @param pinThreads Pin background thread i to the i-th CPU the process
+   * may run on, wrapping around (Linux only). The calling thread is not
+   * pinned; the first allowed CPU is left to it unless there are more threads
+   * than CPUs. pinnedThreads() tells how many threads were pinned.
+   */
+  explicit WorkStealingPool(std::size_t threads = 0, bool pinThreads = false);
+
+  /**
+   * @brief Stops and joins the background threads.
+   */
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  /**
+   * @brief Returns the number of threads, including the calling thread.
+   */
+  std::size_t threads() const;
+
+  /**
+   * @brief Returns the number of background threads pinned to a CPU; zero
+   * without pinThreads or when pinning is not possible.
+   */
+  std::size_t pinnedThreads() const;
+
+  /**
+   * @brief Runs @p task once for every index in [0, tasks) and waits for all
+   * of them to finish.
+   *
+   * @details
+   * The task must not throw. Only one run() may be in progress at a time.
+   */
+  void run(std::size_t tasks, const Task &task);
+
+ private:
+  /**
+   * @brief Task indices [next, end) not yet claimed from one thread's range.
+   */
+  struct alignas(kCacheLineSize) Range {
+    std::atomic<std::size_t> next{0};
+    std::size_t end = 0;
+  };
+
+  void workerLoop(std::size_t thread);
+  void work(std::size_t thread, const Task &task);
+
+  std::vector<Range, CacheAlignedAllocator<Range>> _ranges;
+  std::vector<std::thread> _threads;
+  std::mutex _mutex;
+  std::condition_variable _start;    /**< Signals a new batch or shutdown */
+  std::condition_variable _finished; /**< Signals the end of a batch */
+  const Task *_task = nullptr;       /**< Task of the current batch */
+  std::size_t _generation = 0;       /**< Number of batches started */
+  std::size_t _active = 0;           /**< Background threads still working */
+  std::size_t _pinned = 0;           /**< Background threads pinned to a CPU */
+  bool _stop = false;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef _PLANT_H_
+#define _PLANT_H_
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @file plant.hpp
+ * @brief Discrete-time plant models for closed-loop simulation.
+ *
+ * Every plant is a small value type with the same two members:
+ * - `double step(double u)` applies the input `u` for one sample period and
+ *   returns the new plant output;
+ * - `double output() const` returns the current plant output.
+ *
+ * The models are header-only so that a simulation loop inlines the controller
+ * and the plant into one tight loop.
+ */
+
+/**
+ * @brief First-order lag, `tau * dy/dt + y = K * u`.
+ *
+ * Discretized exactly for an input held constant over each sample (zero-order
+ * hold), so the model is stable and accurate for any sample period.
+ */
+class FirstOrderLag {
+ public:
+  /**
+   * @param K   Static gain.
+   * @param tau Time constant, in the same unit as dt.
+   * @param dt  Sample period.
+   * @param y0  Initial output.
+   */
+  FirstOrderLag(double K, double tau, double dt, double y0 = 0.0)
+      : _a(std::exp(-dt / tau)), _b(K * (1.0 - std::exp(-dt / tau))), _y(y0) {}
+
+  double step(double u) {
+    _y = _a * _y + _b * u;
+    return _y;
+  }
+
+  double output() const { return _y; }
+
+ private:
+  double _a; /**< Pole, exp(-dt / tau) */
+  double _b; /**< Input gain, K * (1 - a) */
+  double _y; /**< Current output */
+};
+
+/**
+ * @brief Second-order system,
+ * `d2y/dt2 + 2 * zeta * wn * dy/dt + wn^2 * y = K * wn^2 * u`.
+ *
+ * Integrated with semi-implicit Euler (velocity first, then position), which
+ * is cheap and stays stable for undamped and lightly damped plants as long as
+ * `wn * dt` is well below 1.
+ */
+class SecondOrder {
+ public:
+  /**
+   * @param K    Static gain.
+   * @param wn   Natural frequency, in rad per time unit.
+   * @param zeta Damping ratio.
+   * @param dt   Sample period.
+   * @param y0   Initial output.
+   */
+  SecondOrder(double K, double wn, double zeta, double dt, double y0 = 0.0)
+      : _k(K * wn * wn),
+        _c(2.0 * zeta * wn),
+        _w2(wn * wn),
+        _dt(dt),
+        _y(y0),
+        _v(0.0) {}
+
+  double step(double u) {
+    _v += _dt * (_k * u - _c * _v - _w2 * _y);
+    _y += _dt * _v;
+    return _y;
+  }
+
+  double output() const { return _y; }
+
+ private:
+  double _k;  /**< Input gain, K * wn^2 */
+  double _c;  /**< Damping, 2 * zeta * wn */
+  double _w2; /**< Stiffness, wn^2 */
+  double _dt; /**< Sample period */
+  double _y;  /**< Current output */
+  double _v;  /**< Current rate of change of the output */
+};
+
+/**
+ * @brief Pure integrator, `dy/dt = K * u`.
+ */
+class Integrator {
+ public:
+  /**
+   * @param K  Integration gain.
+   * @param dt Sample period.
+   * @param y0 Initial output.
+   */
+  Integrator(double K, double dt, double y0 = 0.0) : _kdt(K * dt), _y(y0) {}
+
+  double step(double u) {
+    _y += _kdt * u;
+    return _y;
+  }
+
+  double output() const { return _y; }
+
+ private:
+  double _kdt; /**< K * dt */
+  double _y;   /**< Current output */
+};
+
+/**
+ * @brief Adds a dead time of a whole number of samples in front of another
+ * plant.
+ *
+ * @tparam Plant Any plant model; it receives each input `delay` samples late.
+ */
+template <typename Plant>
+class DeadTime {
+ public:
+  /**
+   * @param plant   The delayed plant.
+   * @param delay   Dead time in samples.
+   * @param u0      Input seen by the plant until the first real input arrives.
+   */
+  DeadTime(const Plant &plant, std::size_t delay, double u0 = 0.0)
+      : _plant(plant), _inputs(delay, u0), _next(0) {}
+
+  double step(double u) {
+    if (_inputs.empty()) return _plant.step(u);
+    double delayed = _inputs[_next];
+    _inputs[_next] = u;
+    if (++_next == _inputs.size()) _next = 0;
+    return _plant.step(delayed);
+  }
+
+  double output() const { return _plant.output(); }
+
+ private:
+  Plant _plant;                /**< Plant behind the delay */
+  std::vector<double> _inputs; /**< Circular buffer of pending inputs */
+  std::size_t _next;           /**< Oldest pending input */
+};
+
+/**
+ * @brief Helper that deduces the plant type of a DeadTime.
+ */
+template <typename Plant>
+DeadTime<Plant> withDeadTime(const Plant &plant, std::size_t delay,
+                             double u0 = 0.0) {
+  return DeadTime<Plant>(plant, delay, u0);
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef _SIMULATION_H_
+#define _SIMULATION_H_
+
+#include <cstddef>
+
+#include "plant.hpp"
+#include "step_metrics.hpp"
+
+/**
+ * @brief Runs a closed-loop step response and returns its metrics.
+ *
+ * @tparam Controller Any controller with `double calculate(double, double)`,
+ * such as PID or BasicPID<double>.
+ * @tparam Plant      Any plant model from plant.hpp.
+ *
+ * @param controller Controller, updated in place.
+ * @param plant      Plant, updated in place; the step starts from its current
+ * output.
+ * @param setpoint   Setpoint applied from the first sample on.
+ * @param steps      Number of samples to simulate.
+ * @param dt         Sample period, used for the time-based metrics.
+ * @param band       Settling band, as a fraction of the step size.
+ *
+ * @details
+ * Each sample feeds the current plant output to the controller, applies the
+ * controller output to the plant, and adds the new plant output to the
+ * metrics. Everything is inlined, and no trajectory is stored, so long runs
+ * need constant memory.
+ */
+template <typename Controller, typename Plant>
+StepMetrics simulateStep(Controller &controller, Plant &plant, double setpoint,
+                         std::size_t steps, double dt, double band = 0.02) {
+  StepMetrics metrics(plant.output(), setpoint, dt, band);
+  double y = plant.output();
+  for (std::size_t k = 0; k < steps; ++k) {
+    y = plant.step(controller.calculate(setpoint, y));
+    metrics.update(y);
+  }
+  return metrics;
+}
+
+#endif
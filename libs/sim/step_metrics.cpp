@@ -0,0 +1,39 @@
+#include "step_metrics.hpp"
+
+#include <limits>
+
+StepMetrics::StepMetrics(double initial, double setpoint, double dt,
+                         double band)
+    : _initial(initial),
+      _setpoint(setpoint),
+      _inv_step(1.0 / (setpoint - initial)),
+      _dt(dt),
+      _band(std::fabs(band * (setpoint - initial))),
+      _steps(0),
+      _peak(-std::numeric_limits<double>::infinity()),
+      _t10(-1.0),
+      _t90(-1.0),
+      _last_outside(0.0),
+      _inside(false),
+      _iae(0.0),
+      _ise(0.0) {}
+
+std::size_t StepMetrics::steps() const { return _steps; }
+
+double StepMetrics::riseTime() const {
+  if (_t90 < 0.0) return std::numeric_limits<double>::infinity();
+  return _t90 - _t10;
+}
+
+double StepMetrics::overshoot() const { return _peak > 1.0 ? _peak - 1.0 : 0.0; }
+
+double StepMetrics::settlingTime() const {
+  // Still outside the band at the last sample: the run never settled.
+  if (!_inside)
+    return std::numeric_limits<double>::infinity();
+  return _last_outside;
+}
+
+double StepMetrics::iae() const { return _iae; }
+
+double StepMetrics::ise() const { return _ise; }
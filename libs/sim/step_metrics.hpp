@@ -0,0 +1,73 @@
+#ifndef _STEP_METRICS_H_
+#define _STEP_METRICS_H_
+
+#include <cmath>
+#include <cstddef>
+
+/**
+ * @brief The StepMetrics class computes step-response metrics incrementally,
+ * one sample at a time, without storing the trajectory.
+ *
+ * The response is measured relative to the step from `initial` to `setpoint`:
+ * - rise time: time from reaching 10% to reaching 90% of the step;
+ * - overshoot: largest excursion past the setpoint, as a fraction of the step;
+ * - settling time: time after which the output stays within `band` (a fraction
+ *   of the step) of the setpoint;
+ * - IAE and ISE: integrals of the absolute and squared error.
+ *
+ * Sample k (counting from 1) is taken at time k * dt. Metrics that were not
+ * reached during the run are reported as infinity.
+ */
+class StepMetrics {
+ public:
+  /**
+   * @param initial  Output before the step.
+   * @param setpoint Target of the step; must differ from @p initial.
+   * @param dt       Sample period.
+   * @param band     Settling band, as a fraction of the step size.
+   */
+  StepMetrics(double initial, double setpoint, double dt, double band = 0.02);
+
+  /**
+   * @brief Adds the next output sample.
+   */
+  void update(double y) {
+    ++_steps;
+    const double t = _steps * _dt;
+    const double error = _setpoint - y;
+    const double progress = (y - _initial) * _inv_step;
+
+    _iae += std::fabs(error) * _dt;
+    _ise += error * error * _dt;
+
+    if (progress > _peak) _peak = progress;
+    if (_t10 < 0.0 && progress >= 0.1) _t10 = t;
+    if (_t90 < 0.0 && progress >= 0.9) _t90 = t;
+    _inside = std::fabs(error) <= _band;
+    if (!_inside) _last_outside = t;
+  }
+
+  std::size_t steps() const; /**< Number of samples seen */
+  double riseTime() const;     /**< 10% to 90% rise time */
+  double overshoot() const;    /**< Peak overshoot, fraction of the step */
+  double settlingTime() const; /**< Time to stay inside the band */
+  double iae() const;          /**< Integral of absolute error */
+  double ise() const;          /**< Integral of squared error */
+
+ private:
+  double _initial;      /**< Output before the step */
+  double _setpoint;     /**< Target of the step */
+  double _inv_step;     /**< 1 / (setpoint - initial) */
+  double _dt;           /**< Sample period */
+  double _band;         /**< Settling band, in output units */
+  std::size_t _steps;   /**< Samples seen */
+  double _peak;         /**< Largest progress seen */
+  double _t10;          /**< Time of reaching 10%, or -1 */
+  double _t90;          /**< Time of reaching 90%, or -1 */
+  double _last_outside; /**< Time of the last sample outside the band */
+  bool _inside;         /**< Whether the last sample is inside the band */
+  double _iae;          /**< Integral of absolute error */
+  double _ise;          /**< Integral of squared error */
+};
+
+#endif
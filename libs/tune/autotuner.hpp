@@ -0,0 +1,334 @@
+#ifndef _AUTOTUNER_H_
+#define _AUTOTUNER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "pid_bank.hpp"
+#include "step_metrics.hpp"
+#include "work_stealing_pool.hpp"
+
+/**
+ * @brief One candidate set of gains, in the order of the PID constructor.
+ */
+struct GainSet {
+  double Kp; /**< Proportional gain */
+  double Kd; /**< Derivative gain */
+  double Ki; /**< Integral gain */
+};
+
+/**
+ * @brief Cost and step-response metrics of one evaluated GainSet.
+ */
+struct TuneResult {
+  GainSet gains;       /**< Evaluated gains */
+  double cost;         /**< Value of the objective; lower is better */
+  double riseTime;     /**< 10% to 90% rise time */
+  double overshoot;    /**< Peak overshoot, fraction of the step */
+  double settlingTime; /**< Time to stay inside the settling band */
+  double iae;          /**< Integral of absolute error */
+  double ise;          /**< Integral of squared error */
+  bool aborted;        /**< Stopped early because it was clearly worse */
+};
+
+/**
+ * @brief Settings shared by every evaluation of an Autotuner.
+ */
+struct TuneOptions {
+  /**
+   * @brief Error integral minimized by the tuner.
+   */
+  enum class Cost { kIAE, kISE };
+
+  double dt = 0.01;             /**< Controller and plant sample period */
+  std::size_t steps = 2000;     /**< Samples per step response */
+  double setpoint = 1.0;        /**< Step target, from the plant output */
+  double max = 100.0;           /**< Maximum controller output */
+  double min = -100.0;          /**< Minimum controller output */
+  double band = 0.02;           /**< Settling band, fraction of the step */
+  Cost cost = Cost::kIAE;       /**< Error integral to minimize */
+  double overshootWeight = 0.0; /**< Added cost per unit of overshoot */
+  double abortFactor = 4.0;     /**< >= 1; abort above this times best */
+  std::size_t batchSize = 64;   /**< Candidates simulated together; >= 4 */
+  std::size_t threads = 0;      /**< Threads; zero uses all hardware ones */
+};
+
+/**
+ * @brief Inclusive range of one gain, sampled at `count` evenly spaced values.
+ */
+struct GainRange {
+  double lo;         /**< First value */
+  double hi;         /**< Last value */
+  std::size_t count; /**< Number of values; 1 samples only lo */
+};
+
+/**
+ * @brief The Autotuner class searches PID gains that minimize a step-response
+ * cost on a plant model.
+ *
+ * @tparam Plant Any plant model from plant.hpp. Every candidate simulates its
+ * own copy of the plant passed to the constructor.
+ *
+ * @details
+ * Candidates are simulated in batches: a batch of gains is loaded into one
+ * PIDBank and all of its loops advance together, one vectorized bank update
+ * per sample. Batches run in parallel on a WorkStealingPool.
+ *
+ * A candidate is aborted as soon as its running error integral exceeds
+ * `abortFactor` times the best cost found so far. Its cost only grows, so a
+ * candidate that could still win is never aborted, and the best result does
+ * not depend on the number of threads.
+ */
+template <typename Plant>
+class Autotuner {
+ public:
+  /**
+   * @param plant   Plant model, copied for every candidate.
+   * @param options Simulation and search settings. A `batchSize` below 4 is
+   * raised to 4, so each Nelder-Mead iteration is evaluated as one batch.
+   *
+   * @throws std::invalid_argument if `abortFactor` is below 1 (or NaN), which
+   * could abort a candidate that would still win.
+   */
+  Autotuner(const Plant &plant, const TuneOptions &options)
+      : _plant(plant),
+        _options(checked(options)),
+        _pool(options.threads),
+        _best(std::numeric_limits<double>::infinity()) {}
+
+  /**
+   * @brief Evaluates every candidate and returns the results in the same
+   * order.
+   */
+  std::vector<TuneResult> evaluate(const std::vector<GainSet> &candidates) {
+    std::vector<TuneResult> results(candidates.size());
+    const std::size_t batch = _options.batchSize;
+    const std::size_t batches = (candidates.size() + batch - 1) / batch;
+    _pool.run(batches, [&](std::size_t b, std::size_t) {
+      std::size_t first = b * batch;
+      std::size_t n = std::min(batch, candidates.size() - first);
+      evaluateBatch(&candidates[first], n, &results[first]);
+    });
+    return results;
+  }
+
+  /**
+   * @brief Evaluates the Cartesian product of three gain ranges and returns
+   * the best result.
+   */
+  TuneResult gridSearch(const GainRange &Kp, const GainRange &Kd,
+                        const GainRange &Ki) {
+    std::vector<GainSet> candidates;
+    candidates.reserve(Kp.count * Kd.count * Ki.count);
+    for (std::size_t p = 0; p < Kp.count; ++p)
+      for (std::size_t d = 0; d < Kd.count; ++d)
+        for (std::size_t i = 0; i < Ki.count; ++i)
+          candidates.push_back(
+              GainSet{sample(Kp, p), sample(Kd, d), sample(Ki, i)});
+    return best(evaluate(candidates));
+  }
+
+  /**
+   * @brief Minimizes the cost with the Nelder-Mead simplex method.
+   *
+   * @param start      Initial gains.
+   * @param scale      Size of the initial simplex along each gain.
+   * @param iterations Maximum number of simplex iterations.
+   * @param tolerance  Stop when the costs of the simplex vertices differ by
+   * less than this.
+   * @return The best result found.
+   *
+   * @details
+   * Gains are kept non-negative. Each iteration evaluates the reflection,
+   * expansion and both contractions as one parallel batch, instead of one
+   * point after the other, so the search keeps all threads busy.
+   */
+  TuneResult nelderMead(const GainSet &start, const GainSet &scale,
+                        std::size_t iterations, double tolerance = 1e-9) {
+    std::vector<GainSet> simplex = {start,
+                                    GainSet{start.Kp + scale.Kp, start.Kd,
+                                            start.Ki},
+                                    GainSet{start.Kp, start.Kd + scale.Kd,
+                                            start.Ki},
+                                    GainSet{start.Kp, start.Kd,
+                                            start.Ki + scale.Ki}};
+    for (GainSet &g : simplex) g = clampGains(g);
+    std::vector<TuneResult> vertices = evaluate(simplex);
+
+    for (std::size_t it = 0; it < iterations; ++it) {
+      std::sort(vertices.begin(), vertices.end(),
+                [](const TuneResult &a, const TuneResult &b) {
+                  return a.cost < b.cost;
+                });
+      const TuneResult &lowest = vertices.front();
+      const TuneResult &worst = vertices.back();
+      if (worst.cost - lowest.cost < tolerance) break;
+
+      // Centroid of every vertex but the worst.
+      GainSet c{0, 0, 0};
+      for (std::size_t v = 0; v + 1 < vertices.size(); ++v) {
+        c.Kp += vertices[v].gains.Kp / 3.0;
+        c.Kd += vertices[v].gains.Kd / 3.0;
+        c.Ki += vertices[v].gains.Ki / 3.0;
+      }
+
+      std::vector<TuneResult> trial = evaluate(
+          {clampGains(along(c, worst.gains, -1.0)),    // reflection
+           clampGains(along(c, worst.gains, -2.0)),    // expansion
+           clampGains(along(c, worst.gains, -0.5)),    // outside contraction
+           clampGains(along(c, worst.gains, 0.5))});  // inside contraction
+      const TuneResult &reflected = trial[0];
+      const TuneResult &second_worst = vertices[vertices.size() - 2];
+
+      if (reflected.cost < lowest.cost) {
+        vertices.back() = trial[1].cost < reflected.cost ? trial[1] : reflected;
+      } else if (reflected.cost < second_worst.cost) {
+        vertices.back() = reflected;
+      } else if (reflected.cost < worst.cost &&
+                 trial[2].cost <= reflected.cost) {
+        vertices.back() = trial[2];
+      } else if (trial[3].cost < worst.cost) {
+        vertices.back() = trial[3];
+      } else {
+        // Shrink every vertex towards the best one.
+        std::vector<GainSet> shrunk;
+        for (std::size_t v = 1; v < vertices.size(); ++v)
+          shrunk.push_back(along(lowest.gains, vertices[v].gains, 0.5));
+        std::vector<TuneResult> moved = evaluate(shrunk);
+        std::copy(moved.begin(), moved.end(), vertices.begin() + 1);
+      }
+    }
+    return best(vertices);
+  }
+
+  /**
+   * @brief Runs a grid search, then refines its best point with Nelder-Mead.
+   */
+  TuneResult tune(const GainRange &Kp, const GainRange &Kd, const GainRange &Ki,
+                  std::size_t iterations = 200) {
+    TuneResult coarse = gridSearch(Kp, Kd, Ki);
+    GainSet scale{step(Kp), step(Kd), step(Ki)};
+    TuneResult fine = nelderMead(coarse.gains, scale, iterations);
+    return fine.cost < coarse.cost ? fine : coarse;
+  }
+
+  /**
+   * @brief Returns the result with the lowest cost.
+   */
+  static TuneResult best(const std::vector<TuneResult> &results) {
+    return *std::min_element(results.begin(), results.end(),
+                             [](const TuneResult &a, const TuneResult &b) {
+                               return a.cost < b.cost;
+                             });
+  }
+
+ private:
+  /**
+   * @brief Validates @p options and raises the batch size to its minimum.
+   */
+  static TuneOptions checked(TuneOptions options) {
+    if (!(options.abortFactor >= 1.0))
+      throw std::invalid_argument("abortFactor must be at least 1");
+    options.batchSize = std::max<std::size_t>(options.batchSize, 4);
+    return options;
+  }
+
+  /**
+   * @brief Simulates @p n candidates together in one PIDBank.
+   */
+  void evaluateBatch(const GainSet *candidates, std::size_t n,
+                     TuneResult *results) {
+    const TuneOptions &o = _options;
+    const bool ise = o.cost == TuneOptions::Cost::kISE;
+
+    PIDBank bank;
+    bank.reserve(n);
+    std::vector<Plant> plants(n, _plant);
+    std::vector<StepMetrics> metrics(
+        n, StepMetrics(_plant.output(), o.setpoint, o.dt, o.band));
+    std::vector<double> setpoints(n, o.setpoint), pvs(n, _plant.output()),
+        outputs(n);
+    std::vector<char> alive(n, 1);
+    for (std::size_t k = 0; k < n; ++k)
+      bank.add(o.dt, o.max, o.min, candidates[k].Kp, candidates[k].Kd,
+               candidates[k].Ki);
+
+    std::size_t remaining = n;
+    for (std::size_t s = 0; s < o.steps && remaining != 0; ++s) {
+      bank.calculate(setpoints.data(), pvs.data(), outputs.data());
+      const double limit =
+          o.abortFactor * _best.load(std::memory_order_relaxed);
+      for (std::size_t k = 0; k < n; ++k) {
+        if (!alive[k]) continue;
+        pvs[k] = plants[k].step(outputs[k]);
+        metrics[k].update(pvs[k]);
+        double running = ise ? metrics[k].ise() : metrics[k].iae();
+        if (running > limit || running != running) {
+          alive[k] = 0;
+          --remaining;
+        }
+      }
+    }
+
+    for (std::size_t k = 0; k < n; ++k) {
+      const StepMetrics &m = metrics[k];
+      TuneResult &r = results[k];
+      r.gains = candidates[k];
+      r.riseTime = m.riseTime();
+      r.overshoot = m.overshoot();
+      r.settlingTime = m.settlingTime();
+      r.iae = m.iae();
+      r.ise = m.ise();
+      r.aborted = !alive[k];
+      r.cost = r.aborted ? std::numeric_limits<double>::infinity()
+                         : (ise ? r.ise : r.iae) +
+                               o.overshootWeight * r.overshoot;
+      if (!r.aborted) lowerBest(r.cost);
+    }
+  }
+
+  /**
+   * @brief Lowers the shared best cost to @p cost if it is smaller.
+   */
+  void lowerBest(double cost) {
+    double current = _best.load(std::memory_order_relaxed);
+    while (cost < current &&
+           !_best.compare_exchange_weak(current, cost,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+
+  static double sample(const GainRange &r, std::size_t k) {
+    return r.count < 2 ? r.lo : r.lo + (r.hi - r.lo) * k / (r.count - 1);
+  }
+
+  static double step(const GainRange &r) {
+    return r.count < 2 ? 0.0 : (r.hi - r.lo) / (r.count - 1);
+  }
+
+  /**
+   * @brief Returns c + t * (p - c).
+   */
+  static GainSet along(const GainSet &c, const GainSet &p, double t) {
+    return GainSet{c.Kp + t * (p.Kp - c.Kp), c.Kd + t * (p.Kd - c.Kd),
+                   c.Ki + t * (p.Ki - c.Ki)};
+  }
+
+  static GainSet clampGains(GainSet g) {
+    g.Kp = std::max(g.Kp, 0.0);
+    g.Kd = std::max(g.Kd, 0.0);
+    g.Ki = std::max(g.Ki, 0.0);
+    return g;
+  }
+
+  Plant _plant;              /**< Plant copied for every candidate */
+  TuneOptions _options;      /**< Simulation and search settings */
+  WorkStealingPool _pool;    /**< Threads running the batches */
+  std::atomic<double> _best; /**< Lowest cost of any finished candidate */
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "autotuner.hpp"
+#include "pid.hpp"
+#include "plant.hpp"
+#include "simulation.hpp"
+
+namespace {
+
+TuneOptions firstOrderOptions(std::size_t threads) {
+  TuneOptions options;
+  options.dt = 0.01;
+  options.steps = 500;
+  options.max = 10.0;
+  options.min = -10.0;
+  options.batchSize = 16;
+  options.threads = threads;
+  return options;
+}
+
+}  // namespace
+
+// test1: Batched evaluation gives the same metrics as simulating one PID.
+TEST(AutotunerTest, EvaluateMatchesSingleSimulation) {
+  const FirstOrderLag plant(1.0, 0.5, 0.01);
+  TuneOptions options = firstOrderOptions(2);
+  options.abortFactor = std::numeric_limits<double>::infinity();
+  Autotuner<FirstOrderLag> tuner(plant, options);
+
+  std::vector<GainSet> candidates;
+  for (int k = 0; k < 40; ++k)
+    candidates.push_back(GainSet{0.5 + 0.1 * k, 0.0, 1.0 + 0.05 * k});
+  std::vector<TuneResult> results = tuner.evaluate(candidates);
+  ASSERT_EQ(results.size(), candidates.size());
+
+  for (std::size_t k = 0; k < candidates.size(); ++k) {
+    PID pid(0.01, 10.0, -10.0, candidates[k].Kp, candidates[k].Kd,
+            candidates[k].Ki);
+    FirstOrderLag p = plant;
+    StepMetrics m = simulateStep(pid, p, 1.0, 500, 0.01);
+    ASSERT_EQ(results[k].iae, m.iae());
+    ASSERT_EQ(results[k].cost, m.iae());
+    ASSERT_FALSE(results[k].aborted);
+  }
+}
+
+// test2: The grid search finds the best grid point whatever the thread count,
+// and Nelder-Mead improves on it.
+TEST(AutotunerTest, GridSearchAndRefine) {
+  const FirstOrderLag plant(1.0, 0.5, 0.01);
+  GainRange Kp{0.5, 5.0, 10}, Kd{0.0, 0.0, 1}, Ki{0.5, 10.0, 10};
+
+  Autotuner<FirstOrderLag> single(plant, firstOrderOptions(1));
+  Autotuner<FirstOrderLag> multi(plant, firstOrderOptions(4));
+  TuneResult a = single.gridSearch(Kp, Kd, Ki);
+  TuneResult b = multi.gridSearch(Kp, Kd, Ki);
+  ASSERT_EQ(a.cost, b.cost);
+  ASSERT_EQ(a.gains.Kp, b.gains.Kp);
+  ASSERT_EQ(a.gains.Ki, b.gains.Ki);
+
+  TuneResult refined = multi.tune(Kp, Kd, Ki, 100);
+  ASSERT_LE(refined.cost, a.cost);
+  ASSERT_GE(refined.gains.Kp, 0.0);
+  ASSERT_TRUE(std::isfinite(refined.settlingTime));
+}
+
+// test3: Clearly bad candidates are aborted once a good one is known.
+TEST(AutotunerTest, AbortsBadCandidates) {
+  const FirstOrderLag plant(1.0, 0.5, 0.01);
+  Autotuner<FirstOrderLag> tuner(plant, firstOrderOptions(1));
+
+  TuneResult good = tuner.evaluate({GainSet{4.0, 0.0, 8.0}})[0];
+  TuneResult bad = tuner.evaluate({GainSet{0.01, 0.0, 0.0}})[0];
+  ASSERT_FALSE(good.aborted);
+  ASSERT_TRUE(bad.aborted);
+  ASSERT_TRUE(std::isinf(bad.cost));
+}
+
+// test4: An abort factor below 1 could drop the winner and is rejected.
+TEST(AutotunerTest, RejectsInvalidOptions) {
+  const FirstOrderLag plant(1.0, 0.5, 0.01);
+  TuneOptions options = firstOrderOptions(1);
+  options.abortFactor = 0.5;
+  ASSERT_THROW(Autotuner<FirstOrderLag>(plant, options), std::invalid_argument);
+  options.abortFactor = std::numeric_limits<double>::quiet_NaN();
+  ASSERT_THROW(Autotuner<FirstOrderLag>(plant, options), std::invalid_argument);
+}
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include "basic_pid.hpp"
+#include "pid.hpp"
+
+// The constructor must be usable in constant expressions.
+constexpr BasicPID<double> kConstexprPID(1.0, 100.0, -100.0, 1.0, 0.1, 0.5);
+static_assert(kConstexprPID.Kp() == 1.0, "BasicPID must be constexpr");
+static_assert(kConstexprPID.integral() == 0.0, "BasicPID must be constexpr");
+
+// test1: The full double specialization must match PID exactly.
+TEST(BasicPIDTest, MatchesPID) {
+  BasicPID<double> basic(0.1, 50.0, -50.0, 2.0, 0.3, 1.5);
+  PID pid(0.1, 50.0, -50.0, 2.0, 0.3, 1.5);
+
+  const double pvs[] = {0.0, 3.0, 7.5, 12.0, 9.0, -4.0, 30.0};
+  for (double pv : pvs) {
+    ASSERT_EQ(basic.calculate(10.0, pv), pid.calculate(10.0, pv));
+  }
+}
+
+// test2: A PI controller ignores Kd and never updates the previous error.
+TEST(BasicPIDTest, PIControllerDropsDerivative) {
+  BasicPID<double, kPI> pi(1.0, 100.0, -100.0, 1.0, 0.1, 0.5);
+
+  // Expected: P = 10, I = 0.5 * 10 = 5, no D.
+  ASSERT_NEAR(pi.calculate(10.0, 0.0), 15.0, 1e-12);
+  ASSERT_EQ(pi.preError(), 0.0);
+}
+
+// test3: Without kClamp the output is not limited to [min, max].
+TEST(BasicPIDTest, UnclampedOutput) {
+  BasicPID<double, kProportional> p(1.0, 1.0, -1.0, 10.0, 0.0, 0.0);
+  ASSERT_EQ(p.calculate(100.0, 0.0), 1000.0);
+}
+
+// test4: The template works with single precision as well.
+TEST(BasicPIDTest, FloatController) {
+  BasicPID<float> pid(1.0f, 100.0f, -100.0f, 1.0f, 0.1f, 0.5f);
+  ASSERT_NEAR(pid.calculate(10.0f, 0.0f), 16.0f, 1e-5f);
+}
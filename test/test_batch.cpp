@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "batch_input.hpp"
+#include "batch_runner.hpp"
+#include "pid.hpp"
+
+namespace {
+
+std::vector<Sample> parse(const std::string &text, WorkStealingPool &pool,
+                          std::size_t chunkBytes = 1 << 22) {
+  return parseCsvSamples(text.data(), text.data() + text.size(), pool,
+                         chunkBytes);
+}
+
+void writeFile(const std::string &path, const void *data, std::size_t size) {
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(std::fwrite(data, 1, size, file), size);
+  std::fclose(file);
+}
+
+}  // namespace
+
+// test1: parseDouble gives exactly the strtod result, on the fast path and
+// on the fallback.
+TEST(BatchInputTest, ParseDoubleMatchesStrtod) {
+  std::mt19937_64 random(7);
+  std::vector<std::string> texts = {"0",      "-0",       "1.5",    "+2.25",
+                                    "1e3",    "1E-3",     "123.",   "0.1",
+                                    "1e400",  "4.9e-324", "1e-22",  "9e22",
+                                    "12345678901234567890123", "0.30000000000000004"};
+  char buffer[64];
+  for (int n = 0; n < 2000; ++n) {
+    double value;
+    std::uint64_t bits = random();
+    std::memcpy(&value, &bits, sizeof value);
+    if (value != value || std::isinf(value)) continue;
+    std::snprintf(buffer, sizeof buffer, n % 2 ? "%.17g" : "%.6f", value);
+    texts.push_back(buffer);
+    std::snprintf(buffer, sizeof buffer, "%.4f", (random() % 200000) / 7.0);
+    texts.push_back(buffer);
+  }
+
+  for (const std::string &text : texts) {
+    const char *p = text.data();
+    double value = 0;
+    ASSERT_TRUE(parseDouble(p, text.data() + text.size(), value)) << text;
+    ASSERT_EQ(p, text.data() + text.size()) << text;
+    ASSERT_EQ(value, std::strtod(text.c_str(), nullptr)) << text;
+  }
+
+  for (const char *bad : {"", "-", ".", "e5", "x"}) {
+    const char *p = bad;
+    double value;
+    ASSERT_FALSE(parseDouble(p, bad + std::strlen(bad), value)) << bad;
+  }
+}
+
+// test2: CSV parsing accepts a header, blank lines, spaces and CRLF, and the
+// result does not depend on the chunk size.
+TEST(BatchInputTest, ParseCsvSamples) {
+  WorkStealingPool pool(3);
+  const std::string text =
+      "controller,setpoint,pv\r\n"
+      "0,10,5\r\n"
+      "\n"
+      " 7 , -1.5e1 ,\t2.25 \n"
+      "4294967295,0,0";
+  std::vector<Sample> samples = parse(text, pool);
+  ASSERT_EQ(samples.size(), 3u);
+  ASSERT_EQ(samples[1].controller, 7u);
+  ASSERT_EQ(samples[1].setpoint, -15.0);
+  ASSERT_EQ(samples[1].pv, 2.25);
+  ASSERT_EQ(samples[2].controller, 4294967295u);
+
+  std::string large;
+  for (int n = 0; n < 5000; ++n)
+    large += std::to_string(n % 97) + "," + std::to_string(n) + ".5,-" +
+             std::to_string(n % 13) + "\n";
+  std::vector<Sample> whole = parse(large, pool);
+  std::vector<Sample> chunked = parse(large, pool, 37);
+  ASSERT_EQ(whole.size(), 5000u);
+  ASSERT_EQ(chunked.size(), whole.size());
+  for (std::size_t i = 0; i < whole.size(); ++i) {
+    ASSERT_EQ(chunked[i].controller, whole[i].controller);
+    ASSERT_EQ(chunked[i].setpoint, whole[i].setpoint);
+    ASSERT_EQ(chunked[i].pv, whole[i].pv);
+  }
+}
+
+// test3: Malformed samples are reported with their byte offset.
+TEST(BatchInputTest, MalformedSample) {
+  WorkStealingPool pool(2);
+  try {
+    parse("1,2,3\n1,2\n", pool);
+    FAIL() << "expected an exception";
+  } catch (const std::runtime_error &e) {
+    ASSERT_NE(std::string(e.what()).find("byte 6"), std::string::npos);
+  }
+  ASSERT_THROW(parse("1,2,3,4\n", pool), std::runtime_error);
+  ASSERT_THROW(parse("1,2,3\n-1,2,3\n", pool), std::runtime_error);
+  ASSERT_THROW(parse("1,2,3\n99999999999,2,3\n", pool), std::runtime_error);
+}
+
+// test4: The config accepts comments and a header and rejects duplicates.
+TEST(BatchRunnerTest, ParseConfig) {
+  const std::string text =
+      "id,dt,max,min,Kp,Kd,Ki\n"
+      "# outer loops\n"
+      "3, 0.1, 100, -100, 0.1, 0.01, 0.5\n"
+      "\n"
+      "10,0.01,1,-1,2,0,1\r\n";
+  std::vector<ControllerConfig> config =
+      parseConfig(text.data(), text.data() + text.size());
+  ASSERT_EQ(config.size(), 2u);
+  ASSERT_EQ(config[0].id, 3u);
+  ASSERT_EQ(config[0].Ki, 0.5);
+  ASSERT_EQ(config[1].dt, 0.01);
+
+  const std::string duplicate = "1,1,1,1,1,1,1\n1,1,1,1,1,1,1\n";
+  ASSERT_THROW(parseConfig(duplicate.data(),
+                           duplicate.data() + duplicate.size()),
+               std::runtime_error);
+  const std::string short_line = "1,1,1,1,1,1\n";
+  ASSERT_THROW(parseConfig(short_line.data(),
+                           short_line.data() + short_line.size()),
+               std::runtime_error);
+}
+
+// test5: The sharded runner gives every controller its samples in input
+// order, for any number of threads and shards.
+TEST(BatchRunnerTest, MatchesSequentialControllers) {
+  std::vector<ControllerConfig> config;
+  for (std::uint32_t id = 0; id < 200; id += 2)
+    config.push_back({id, 0.1, 20.0, -20.0, 0.5 + id % 5, 0.05, 0.5});
+
+  std::mt19937 random(3);
+  std::vector<Sample> samples(200000);
+  for (Sample &sample : samples)
+    sample = {static_cast<std::uint32_t>(random() % 100 * 2), 0, 10.0,
+              static_cast<double>(random() % 4000) / 100.0 - 20.0};
+
+  std::vector<PID> pids;
+  for (std::uint32_t id = 0; id < 200; ++id)
+    pids.emplace_back(0.1, 20.0, -20.0, 0.5 + id % 5, 0.05, 0.5);
+  std::vector<double> expected(samples.size());
+  for (std::size_t i = 0; i < samples.size(); ++i)
+    expected[i] = pids[samples[i].controller].calculate(samples[i].setpoint,
+                                                        samples[i].pv);
+
+  for (std::size_t threads : {1u, 4u}) {
+    WorkStealingPool pool(threads);
+    BatchRunner runner(config, pool, threads * 3);
+    ASSERT_EQ(runner.controllers(), 100u);
+    std::vector<double> outputs(samples.size());
+    runner.run(samples.data(), samples.size(), outputs.data());
+    ASSERT_EQ(outputs, expected);
+  }
+}
+
+// test6: A sample for an unknown controller is rejected before anything
+// runs.
+TEST(BatchRunnerTest, UnknownController) {
+  WorkStealingPool pool(2);
+  std::vector<ControllerConfig> config = {{0, 1.0, 10, -10, 1, 0, 1},
+                                          {2, 1.0, 10, -10, 1, 0, 1}};
+  BatchRunner runner(config, pool);
+  std::vector<Sample> samples = {{0, 0, 1, 0}, {1, 0, 1, 0}};
+  std::vector<double> outputs(2);
+  ASSERT_THROW(runner.run(samples.data(), 2, outputs.data()),
+               std::out_of_range);
+
+  // Controller 0 was not updated: its integral still starts from zero.
+  runner.run(samples.data(), 1, outputs.data());
+  ASSERT_EQ(outputs[0], 2.0);
+}
+
+// test7: Sparse ids up to the largest 32-bit value only cost their own
+// controllers.
+TEST(BatchRunnerTest, SparseIds) {
+  const std::string text =
+      "4294967295,1,10,-10,1,0,1\n"
+      "300000000,1,10,-10,2,0,0\n"
+      "7,1,10,-10,0,0,1\n";
+  std::vector<ControllerConfig> config =
+      parseConfig(text.data(), text.data() + text.size());
+  ASSERT_EQ(config.size(), 3u);
+  ASSERT_EQ(config[0].id, 4294967295u);
+
+  WorkStealingPool pool(2);
+  BatchRunner runner(config, pool);
+  ASSERT_EQ(runner.controllers(), 3u);
+  std::vector<Sample> samples = {{4294967295u, 0, 1, 0},
+                                 {300000000, 0, 1, 0},
+                                 {7, 0, 1, 0},
+                                 {4294967295u, 0, 1, 0}};
+  std::vector<double> outputs(samples.size());
+  runner.run(samples.data(), samples.size(), outputs.data());
+  ASSERT_EQ(outputs, (std::vector<double>{2.0, 2.0, 1.0, 3.0}));
+
+  samples[1].controller = 300000001;
+  ASSERT_THROW(runner.run(samples.data(), samples.size(), outputs.data()),
+               std::out_of_range);
+
+  config.push_back(config[1]);
+  ASSERT_THROW(BatchRunner(config, pool), std::invalid_argument);
+}
+
+// test8: Binary sample files are used in place and CSV files are parsed;
+// CSV outputs read back to the same doubles.
+TEST(BatchRunnerTest, FilesRoundTrip) {
+  WorkStealingPool pool(2);
+  std::vector<Sample> samples = {{1, 0, 10.0, 1.0 / 3}, {0, 0, -2.5, 7.0}};
+
+  const std::string binary_path = ::testing::TempDir() + "pid_batch_test.bin";
+  std::vector<char> bytes(sizeof(SampleFileHeader) +
+                          samples.size() * sizeof(Sample));
+  SampleFileHeader header = sampleFileHeader(samples.size());
+  std::memcpy(bytes.data(), &header, sizeof header);
+  std::memcpy(bytes.data() + sizeof header, samples.data(),
+              samples.size() * sizeof(Sample));
+  writeFile(binary_path, bytes.data(), bytes.size());
+  {
+    SampleInput input(binary_path, pool);
+    ASSERT_TRUE(input.binary());
+    ASSERT_EQ(input.size(), 2u);
+    ASSERT_EQ(input.data()[0].pv, 1.0 / 3);
+  }
+  std::remove(binary_path.c_str());
+
+  const std::string csv_path = ::testing::TempDir() + "pid_batch_test.csv";
+  const std::string csv = "1,10,0.5\n0,-2.5,7\n";
+  writeFile(csv_path, csv.data(), csv.size());
+  {
+    SampleInput input(csv_path, pool);
+    ASSERT_FALSE(input.binary());
+    ASSERT_EQ(input.size(), 2u);
+    ASSERT_EQ(input.data()[1].setpoint, -2.5);
+  }
+
+  const double outputs[] = {1.0 / 3, -1e-300};
+  std::FILE *out = std::fopen(csv_path.c_str(), "wb");
+  ASSERT_NE(out, nullptr);
+  writeCsvOutputs(out, samples.data(), outputs, 2, pool);
+  std::fclose(out);
+  {
+    MappedFile file(csv_path);
+    const std::string text(file.data(), file.size());
+    const std::size_t eol = text.find('\n');
+    ASSERT_EQ(text.compare(0, 2, "1,"), 0);
+    ASSERT_EQ(std::strtod(text.c_str() + 2, nullptr), outputs[0]);
+    ASSERT_EQ(text.compare(eol + 1, 2, "0,"), 0);
+    ASSERT_EQ(std::strtod(text.c_str() + eol + 3, nullptr), outputs[1]);
+    ASSERT_EQ(text.back(), '\n');
+  }
+  std::remove(csv_path.c_str());
+}
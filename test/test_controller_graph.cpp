@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "controller_graph.hpp"
+#include "pid.hpp"
+
+namespace {
+
+// Builds `count` independent three-level cascades; returns the nodes of each
+// level, outermost first.
+std::vector<std::vector<ControllerGraph::Node>> addCascades(
+    ControllerGraph &graph, std::size_t count) {
+  std::vector<std::vector<ControllerGraph::Node>> levels(3);
+  for (std::size_t n = 0; n < count; ++n) {
+    auto outer = graph.addLoop(0.1, 20.0, -20.0, 1.0 + n % 3, 0.01, 0.5);
+    auto middle = graph.addLoop(0.1, 10.0, -10.0, 2.0, 0.02, 0.25);
+    auto inner = graph.addLoop(0.1, 5.0, -5.0, 0.5, 0.0, 1.0);
+    graph.cascade(outer, middle);
+    graph.cascade(middle, inner, 0.5);
+    levels[0].push_back(outer);
+    levels[1].push_back(middle);
+    levels[2].push_back(inner);
+  }
+  return levels;
+}
+
+}  // namespace
+
+// test1: A compiled cascade gives exactly the outputs of PIDs wired by hand.
+TEST(ControllerGraphTest, MatchesHandWiredCascade) {
+  ControllerGraph graph;
+  auto levels = addCascades(graph, 1);
+  ControllerPlan plan(graph, 1);
+
+  PID outer(0.1, 20.0, -20.0, 1.0, 0.01, 0.5);
+  PID middle(0.1, 10.0, -10.0, 2.0, 0.02, 0.25);
+  PID inner(0.1, 5.0, -5.0, 0.5, 0.0, 1.0);
+
+  const std::size_t o = plan.slot(levels[0][0]), m = plan.slot(levels[1][0]),
+                    i = plan.slot(levels[2][0]);
+  for (int t = 0; t < 20; ++t) {
+    const double pvs[3] = {0.5 * t, 0.3 * t - 1.0, 0.1 * t};
+    plan.setpoints()[o] = 10.0;
+    plan.pvs()[o] = pvs[0];
+    plan.pvs()[m] = pvs[1];
+    plan.pvs()[i] = pvs[2];
+    plan.tick();
+
+    double u_outer = outer.calculate(10.0, pvs[0]);
+    double u_middle = middle.calculate(u_outer, pvs[1]);
+    double u_inner = inner.calculate(0.5 * u_middle, pvs[2]);
+    ASSERT_EQ(plan.outputs()[o], u_outer);
+    ASSERT_EQ(plan.outputs()[m], u_middle);
+    ASSERT_EQ(plan.outputs()[i], u_inner);
+  }
+}
+
+// test2: Independent cascades are grouped into tasks, and the outputs do
+// not depend on the number of threads.
+TEST(ControllerGraphTest, DeterministicAcrossThreadCounts) {
+  ControllerGraph graph;
+  auto levels = addCascades(graph, 100);
+  ControllerPlan serial(graph, 1, 30);
+  ControllerPlan parallel(graph, 4, 30);
+  ASSERT_EQ(serial.tasks(), 10u);
+  ASSERT_EQ(parallel.size(), 300u);
+
+  // Each task of ten cascades starts on a cache line.
+  for (std::size_t n = 0; n < 100; n += 10)
+    ASSERT_EQ(serial.slot(levels[0][n]) % kDoublesPerLine, 0u);
+  ASSERT_EQ(serial.slots(), 9 * 32 + 30u);
+
+  for (int t = 0; t < 10; ++t) {
+    for (std::size_t node = 0; node < graph.size(); ++node) {
+      double pv = 0.01 * static_cast<double>(node) - t;
+      serial.pvs()[serial.slot(node)] = pv;
+      parallel.pvs()[parallel.slot(node)] = pv;
+    }
+    for (auto node : levels[0]) {
+      serial.setpoints()[serial.slot(node)] = 5.0 + t;
+      parallel.setpoints()[parallel.slot(node)] = 5.0 + t;
+    }
+    serial.tick();
+    parallel.tick();
+    for (std::size_t node = 0; node < graph.size(); ++node)
+      ASSERT_EQ(serial.outputs()[serial.slot(node)],
+                parallel.outputs()[parallel.slot(node)]);
+  }
+}
+
+// test3: Feed-forward is added to the clamped output and clamped again.
+TEST(ControllerGraphTest, FeedForward) {
+  ControllerGraph graph;
+  auto a = graph.addLoop(1.0, 100.0, -100.0, 1.0, 0.0, 0.0);
+  auto b = graph.addLoop(1.0, 10.0, -10.0, 1.0, 0.0, 0.0);
+  graph.feedForward(a, b, 0.5);
+  ControllerPlan plan(graph, 1);
+
+  plan.setpoints()[plan.slot(a)] = 4.0;
+  plan.setpoints()[plan.slot(b)] = 1.0;
+  plan.tick();
+  ASSERT_EQ(plan.outputs()[plan.slot(b)], 1.0 + 0.5 * 4.0);
+
+  plan.setpoints()[plan.slot(a)] = 40.0;
+  plan.tick();
+  ASSERT_EQ(plan.outputs()[plan.slot(b)], 10.0);
+}
+
+// test4: Cycles and unknown loops are rejected.
+TEST(ControllerGraphTest, InvalidGraphs) {
+  ControllerGraph graph;
+  auto a = graph.addLoop(1.0, 1.0, -1.0, 1.0, 0.0, 0.0);
+  auto b = graph.addLoop(1.0, 1.0, -1.0, 1.0, 0.0, 0.0);
+  ASSERT_THROW(graph.cascade(a, 2), std::out_of_range);
+  graph.cascade(a, b);
+  graph.feedForward(b, a, 1.0);
+  ASSERT_THROW(ControllerPlan plan(graph), std::invalid_argument);
+}
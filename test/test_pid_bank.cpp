@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "pid.hpp"
+#include "pid_bank.hpp"
+
+namespace {
+
+// Compares two doubles bit by bit, so that NaN payloads and signed zeros
+// must match as well.
+bool bitEqual(double a, double b) {
+  std::uint64_t ua, ub;
+  std::memcpy(&ua, &a, sizeof ua);
+  std::memcpy(&ub, &b, sizeof ub);
+  return ua == ub;
+}
+
+// Deterministic pseudo-random values in [-range, range).
+class Lcg {
+ public:
+  explicit Lcg(std::uint64_t seed) : _state(seed) {}
+  double next(double range) {
+    _state = _state * 6364136223846793005ULL + 1442695040888963407ULL;
+    double unit = static_cast<double>(_state >> 11) / 9007199254740992.0;
+    return (2.0 * unit - 1.0) * range;
+  }
+
+ private:
+  std::uint64_t _state;
+};
+
+}  // namespace
+
+// test1: Every kernel must produce bit-identical outputs to separate PID
+// objects over several steps, including saturated ones.
+TEST(PIDBankTest, MatchesSeparatePIDs) {
+  const PIDBank::Kernel kernels[] = {PIDBank::Kernel::kScalar,
+                                     PIDBank::Kernel::kSSE2,
+                                     PIDBank::Kernel::kAVX2};
+  // An odd count exercises the scalar remainder of the vector kernels.
+  const std::size_t count = 37;
+  const int steps = 20;
+
+  for (PIDBank::Kernel kernel : kernels) {
+    if (!PIDBank::kernelSupported(kernel)) continue;
+
+    Lcg rng(42);
+    PIDBank bank;
+    bank.setKernel(kernel);
+    ASSERT_EQ(bank.kernel(), kernel);
+
+    std::vector<PID *> pids;
+    for (std::size_t i = 0; i < count; ++i) {
+      double dt = 0.01 + rng.next(0.005);
+      double max = 20.0 + rng.next(10.0);
+      double min = -20.0 + rng.next(10.0);
+      double Kp = rng.next(5.0);
+      double Kd = rng.next(0.5);
+      double Ki = rng.next(2.0);
+      bank.add(dt, max, min, Kp, Kd, Ki);
+      pids.push_back(new PID(dt, max, min, Kp, Kd, Ki));
+    }
+    ASSERT_EQ(bank.size(), count);
+
+    std::vector<double> setpoints(count), pvs(count), outputs(count);
+    for (int step = 0; step < steps; ++step) {
+      for (std::size_t i = 0; i < count; ++i) {
+        setpoints[i] = rng.next(50.0);
+        pvs[i] = rng.next(50.0);
+      }
+      bank.calculate(setpoints.data(), pvs.data(), outputs.data());
+      for (std::size_t i = 0; i < count; ++i) {
+        double expected = pids[i]->calculate(setpoints[i], pvs[i]);
+        ASSERT_TRUE(bitEqual(outputs[i], expected))
+            << "kernel " << static_cast<int>(kernel) << ", step " << step
+            << ", controller " << i << ": " << outputs[i]
+            << " != " << expected;
+      }
+    }
+
+    for (PID *pid : pids) delete pid;
+  }
+}
+
+// test2: Updating a sub-range must leave the other controllers untouched.
+TEST(PIDBankTest, CalculateRange) {
+  PIDBank bank;
+  for (int i = 0; i < 8; ++i) bank.add(1.0, 100.0, -100.0, 1.0, 0.1, 0.5);
+
+  double setpoints[3] = {10.0, 10.0, 10.0};
+  double pvs[3] = {0.0, 0.0, 0.0};
+  double outputs[3];
+  bank.calculate(2, 3, setpoints, pvs, outputs);
+  for (double output : outputs) ASSERT_NEAR(output, 16.0, 0.01);
+
+  // Controllers outside of [2, 5) still have zero state, so their first
+  // update gives the same output as a fresh PID.
+  double all_setpoints[8], all_pvs[8], all_outputs[8];
+  for (int i = 0; i < 8; ++i) {
+    all_setpoints[i] = 10.0;
+    all_pvs[i] = 0.0;
+  }
+  bank.calculate(all_setpoints, all_pvs, all_outputs);
+  ASSERT_NEAR(all_outputs[0], 16.0, 0.01);
+  ASSERT_NEAR(all_outputs[2], 20.0, 0.01);
+  ASSERT_NEAR(all_outputs[7], 16.0, 0.01);
+}
+
+// test3: Inverted limits (min > max) clamp like the scalar if/else-if chain in
+// every kernel: above max gives max, otherwise below min gives min.
+TEST(PIDBankTest, InvertedLimitsMatchAcrossKernels) {
+  const PIDBank::Kernel kernels[] = {PIDBank::Kernel::kScalar,
+                                     PIDBank::Kernel::kSSE2,
+                                     PIDBank::Kernel::kAVX2};
+  // Pure P controllers, so the output is the error: 3, 7, 12 and -1 against
+  // max 5, min 10.
+  const double pvs[] = {0, 0, 0, 0, 0};
+  const double setpoints[] = {3.0, 7.0, 12.0, -1.0, 3.0};
+  const double expected[] = {10.0, 5.0, 5.0, 10.0, 10.0};
+
+  for (PIDBank::Kernel kernel : kernels) {
+    if (!PIDBank::kernelSupported(kernel)) continue;
+    PIDBank bank;
+    bank.setKernel(kernel);
+    for (int i = 0; i < 5; ++i) bank.add(1.0, 5.0, 10.0, 1.0, 0.0, 0.0);
+
+    double outputs[5];
+    bank.calculate(setpoints, pvs, outputs);
+    for (int i = 0; i < 5; ++i) {
+      PID pid(1.0, 5.0, 10.0, 1.0, 0.0, 0.0);
+      ASSERT_EQ(pid.calculate(setpoints[i], pvs[i]), expected[i]);
+      ASSERT_EQ(outputs[i], expected[i])
+          << "kernel " << static_cast<int>(kernel) << ", controller " << i;
+    }
+  }
+}
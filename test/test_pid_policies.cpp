@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include "basic_pid.hpp"
+#include "pid.hpp"
+
+// Disabled policies are empty bases and must not grow the controller.
+static_assert(sizeof(BasicPID<double>) == 9 * sizeof(double),
+              "disabled policies must take no space");
+
+// test1: Without saturation, the anti-windup policies do not change the
+// output of a plain PID.
+TEST(PIDPoliciesTest, AntiWindupInactiveWhenUnsaturated) {
+  BasicPID<double> plain(0.1, 100.0, -100.0, 1.0, 0.1, 0.5);
+  BasicPID<double, kPIDTerms | kConditionalIntegration> conditional(
+      0.1, 100.0, -100.0, 1.0, 0.1, 0.5);
+  BasicPID<double, kPIDTerms | kBackCalculation> back(0.1, 100.0, -100.0, 1.0,
+                                                      0.1, 0.5);
+
+  const double pvs[] = {0.0, 2.0, 5.0, 8.0, 9.5, 10.5, 10.0};
+  for (double pv : pvs) {
+    double expected = plain.calculate(10.0, pv);
+    ASSERT_EQ(conditional.calculate(10.0, pv), expected);
+    ASSERT_EQ(back.calculate(10.0, pv), expected);
+  }
+}
+
+// test2: Conditional integration stops the integral from growing while the
+// output is saturated; a plain PID keeps winding up.
+TEST(PIDPoliciesTest, ConditionalIntegrationLimitsWindup) {
+  BasicPID<double, kPI> plain(0.1, 1.0, -1.0, 0.5, 0.0, 1.0);
+  BasicPID<double, kPI | kConditionalIntegration> conditional(0.1, 1.0, -1.0,
+                                                              0.5, 0.0, 1.0);
+  for (int n = 0; n < 100; ++n) {
+    ASSERT_EQ(plain.calculate(10.0, 0.0), 1.0);
+    ASSERT_EQ(conditional.calculate(10.0, 0.0), 1.0);
+  }
+  ASSERT_NEAR(plain.integral(), 100.0, 1e-9);
+  ASSERT_EQ(conditional.integral(), 0.0);
+
+  // Once the error reverses, the conditioned controller leaves saturation
+  // immediately.
+  ASSERT_LT(conditional.calculate(10.0, 11.0), 0.0);
+  ASSERT_EQ(plain.calculate(10.0, 11.0), 1.0);
+}
+
+// test3: Back-calculation pulls the integral back towards the value that
+// just saturates the output.
+TEST(PIDPoliciesTest, BackCalculationUnwindsIntegral) {
+  BasicPID<double, kPI | kBackCalculation> pid(0.1, 1.0, -1.0, 0.05, 0.0,
+                                               1.0);
+  pid.setTrackingGain(10.0);
+  for (int n = 0; n < 1000; ++n) pid.calculate(10.0, 0.0);
+
+  // With Kt * dt = 1 each step unwinds the integral completely, to the value
+  // whose I term just reaches max - P = 0.5.
+  ASSERT_NEAR(pid.integral(), 0.5, 1e-12);
+}
+
+// test4: Derivative on measurement has no kick on the first sample or on a
+// setpoint step.
+TEST(PIDPoliciesTest, DerivativeOnMeasurementHasNoSetpointKick) {
+  BasicPID<double, kPD | kDerivativeOnMeasurement> pid(0.1, 1000.0, -1000.0,
+                                                       0.0, 1.0, 0.0);
+  PIDContributions<double> terms;
+  pid.calculate(0.0, 5.0, terms);
+  ASSERT_EQ(terms.d, 0.0);
+  pid.calculate(10.0, 5.0, terms);
+  ASSERT_EQ(terms.d, 0.0);
+
+  // A change of the measurement still acts: d(-pv)/dt = -20.
+  pid.calculate(10.0, 7.0, terms);
+  ASSERT_NEAR(terms.d, -20.0, 1e-9);
+}
+
+// test5: The derivative filter is a first-order low-pass of the raw
+// derivative; a zero time constant passes it through.
+TEST(PIDPoliciesTest, DerivativeFilter) {
+  BasicPID<double, kPD | kDerivativeFilter> filtered(0.1, 1000.0, -1000.0,
+                                                     0.0, 1.0, 0.0);
+  BasicPID<double, kPD> plain(0.1, 1000.0, -1000.0, 0.0, 1.0, 0.0);
+  ASSERT_EQ(filtered.calculate(1.0, 0.0), plain.calculate(1.0, 0.0));
+
+  BasicPID<double, kPD | kDerivativeFilter> pid(0.1, 1000.0, -1000.0, 0.0,
+                                                1.0, 0.0);
+  pid.setDerivativeFilter(0.3);  // alpha = 0.3 / 0.4 = 0.75
+  // Raw derivative of the step: 10.
+  ASSERT_NEAR(pid.calculate(1.0, 0.0), 2.5, 1e-12);
+  // Raw derivative 0: the filtered value decays by alpha.
+  ASSERT_NEAR(pid.calculate(1.0, 0.0), 1.875, 1e-12);
+
+  // Irregular samples use their own filter constant: 0.3 / (0.3 + 0.3).
+  ASSERT_NEAR(pid.calculate(1.0, 0.0, 0.3), 0.9375, 1e-12);
+}
+
+// test6: Setpoint weights scale the setpoint in the P and D terms only.
+TEST(PIDPoliciesTest, SetpointWeighting) {
+  BasicPID<double, kPIDTerms | kSetpointWeighting> pid(1.0, 1000.0, -1000.0,
+                                                       2.0, 1.0, 0.5);
+  pid.setSetpointWeights(0.5, 0.0);
+  PIDContributions<double> terms;
+  pid.calculate(10.0, 4.0, terms);
+  ASSERT_NEAR(terms.p, 2.0 * (0.5 * 10.0 - 4.0), 1e-12);
+  ASSERT_NEAR(terms.i, 0.5 * 6.0, 1e-12);
+  ASSERT_NEAR(terms.d, -4.0, 1e-12);
+
+  // Unit weights reproduce the plain controller exactly.
+  BasicPID<double, kPIDTerms | kSetpointWeighting> unit(1.0, 1000.0, -1000.0,
+                                                        2.0, 1.0, 0.5);
+  BasicPID<double> plain(1.0, 1000.0, -1000.0, 2.0, 1.0, 0.5);
+  const double pvs[] = {0.0, 3.0, 7.5, 12.0};
+  for (double pv : pvs)
+    ASSERT_EQ(unit.calculate(10.0, pv), plain.calculate(10.0, pv));
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "pid_bank.hpp"
+#include "pid_scheduler.hpp"
+#include "work_stealing_pool.hpp"
+
+// test1: Every task index runs exactly once, whatever the thread count.
+TEST(WorkStealingPoolTest, RunsEveryTaskOnce) {
+  WorkStealingPool pool(4);
+  ASSERT_EQ(pool.threads(), 4u);
+
+  for (std::size_t tasks : {0u, 1u, 3u, 1000u}) {
+    std::vector<std::atomic<int>> counts(tasks);
+    pool.run(tasks, [&](std::size_t task, std::size_t thread) {
+      ASSERT_LT(thread, 4u);
+      counts[task].fetch_add(1);
+    });
+    for (auto &count : counts) ASSERT_EQ(count.load(), 1);
+  }
+}
+
+// test2: The outputs do not depend on the number of threads and match a
+// single-threaded PIDBank bit for bit.
+TEST(PIDSchedulerTest, DeterministicAcrossThreadCounts) {
+  const std::size_t count = 1000;
+  const int ticks = 5;
+
+  PIDBank reference;
+  std::vector<double> expected(count * ticks);
+  std::vector<double> setpoints(count), pvs(count);
+  for (std::size_t i = 0; i < count; ++i)
+    reference.add(0.01 * (1 + i % 7), 50.0, -50.0, 1.0 + i % 3, 0.01, 0.5);
+  for (int t = 0; t < ticks; ++t) {
+    for (std::size_t i = 0; i < count; ++i) {
+      setpoints[i] = 10.0 + t;
+      pvs[i] = 0.1 * static_cast<double>(i % 50) - t;
+    }
+    reference.calculate(setpoints.data(), pvs.data(), &expected[t * count]);
+  }
+
+  for (std::size_t threads : {1u, 2u, 3u, 8u}) {
+    PIDScheduler scheduler(threads, 24);
+    ASSERT_EQ(scheduler.chunkSize(), 24u);
+    for (std::size_t i = 0; i < count; ++i)
+      scheduler.add(0.01 * (1 + i % 7), 50.0, -50.0, 1.0 + i % 3, 0.01, 0.5);
+
+    for (int t = 0; t < ticks; ++t) {
+      for (std::size_t i = 0; i < count; ++i) {
+        scheduler.setpoints()[i] = 10.0 + t;
+        scheduler.pvs()[i] = 0.1 * static_cast<double>(i % 50) - t;
+      }
+      scheduler.tick();
+      for (std::size_t i = 0; i < count; ++i)
+        ASSERT_EQ(scheduler.outputs()[i], expected[t * count + i])
+            << "threads " << threads << ", tick " << t << ", controller " << i;
+    }
+    ASSERT_GT(scheduler.lastTickTime().count(), 0);
+  }
+}
+
+// test3: The chunk size is rounded up to whole cache lines.
+TEST(PIDSchedulerTest, ChunkSizeIsCacheLineMultiple) {
+  PIDScheduler scheduler(1, 10);
+  ASSERT_EQ(scheduler.chunkSize() % (kCacheLineSize / sizeof(double)), 0u);
+  ASSERT_GE(scheduler.chunkSize(), 10u);
+}
+
+// test4: Pinned pools still run every task, and report their pinned threads;
+// unpinned pools pin nothing.
+TEST(WorkStealingPoolTest, PinnedThreads) {
+  WorkStealingPool unpinned(3);
+  ASSERT_EQ(unpinned.pinnedThreads(), 0u);
+
+  WorkStealingPool pinned(3, true);
+  ASSERT_LE(pinned.pinnedThreads(), 2u);
+#ifdef __linux__
+  ASSERT_EQ(pinned.pinnedThreads(), 2u);
+#endif
+  std::atomic<std::size_t> sum{0};
+  pinned.run(100, [&](std::size_t task, std::size_t) { sum += task; });
+  ASSERT_EQ(sum.load(), 4950u);
+}
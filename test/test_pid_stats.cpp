@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "pid.hpp"
+#include "pid_stats.hpp"
+
+// test1: Buckets are exact below 16 and at most 1/16 wide above.
+TEST(LatencyHistogramTest, BucketBounds) {
+  for (std::uint64_t value = 0; value < 16; ++value)
+    ASSERT_EQ(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucket(value)),
+              value);
+  for (std::uint64_t value : {16ull, 17ull, 100ull, 1000ull, 123456ull,
+                              (1ull << 32) - 1}) {
+    std::uint64_t upper =
+        LatencyHistogram::bucketUpperBound(LatencyHistogram::bucket(value));
+    ASSERT_GE(upper, value);
+    ASSERT_LE(upper - value, value / 16);
+  }
+  ASSERT_EQ(LatencyHistogram::bucket(1ull << 40), LatencyHistogram::kBuckets - 1);
+}
+
+// test2: Percentiles within the bucket resolution.
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram histogram;
+  ASSERT_EQ(histogram.percentile(0.5), 0u);
+  for (std::uint64_t value = 1; value <= 1000; ++value) histogram.record(value);
+
+  ASSERT_EQ(histogram.count(), 1000u);
+  ASSERT_EQ(histogram.max(), 1000u);
+  ASSERT_NEAR(static_cast<double>(histogram.percentile(0.5)), 500.0, 500 / 16.0);
+  ASSERT_NEAR(static_cast<double>(histogram.percentile(0.99)), 990.0,
+              990 / 16.0);
+  ASSERT_EQ(histogram.percentile(1.0), 1000u);
+
+  LatencyHistogram other;
+  other.record(5000);
+  histogram.merge(other);
+  ASSERT_EQ(histogram.count(), 1001u);
+  ASSERT_EQ(histogram.max(), 5000u);
+}
+
+// test3: Welford's mean and variance match the textbook formulas.
+TEST(RunningStatsTest, MeanAndVariance) {
+  RunningStats stats;
+  for (double value : {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0}) stats.add(value);
+  ASSERT_EQ(stats.count(), 8u);
+  ASSERT_DOUBLE_EQ(stats.mean(), 5.0);
+  ASSERT_DOUBLE_EQ(stats.variance(), 4.0);
+
+  // Stable with a large offset, where the naive sum of squares fails.
+  RunningStats offset;
+  for (double value : {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0})
+    offset.add(1e9 + value);
+  ASSERT_NEAR(offset.variance(), 4.0, 1e-6);
+}
+
+#if PID_INSTRUMENTATION
+// test4: A PID with stats counts saturation and tracks the integral and the
+// error, without changing its outputs.
+TEST(PIDStatsTest, RecordsControllerActivity) {
+  PIDStats stats;
+  PID pid(0.1, 5.0, -5.0, 1.0, 0.0, 1.0);
+  PID reference(0.1, 5.0, -5.0, 1.0, 0.0, 1.0);
+  pid.setStats(&stats);
+
+  const double pvs[] = {0.0, 0.0, 20.0, 9.0};
+  for (double pv : pvs)
+    ASSERT_EQ(pid.calculate(10.0, pv), reference.calculate(10.0, pv));
+
+  PIDStatsSnapshot snapshot = stats.snapshot();
+  ASSERT_EQ(snapshot.updates, 4u);
+  ASSERT_EQ(snapshot.saturated_high, 2u);
+  ASSERT_EQ(snapshot.saturated_low, 1u);
+  ASSERT_NEAR(snapshot.integral, 1.0 + 1.0 - 1.0 + 0.1, 1e-12);
+  ASSERT_NEAR(snapshot.integral_peak, 2.0, 1e-12);
+  ASSERT_DOUBLE_EQ(snapshot.error_mean, (10.0 + 10.0 - 10.0 + 1.0) / 4);
+  ASSERT_EQ(stats.latency().count(), 4u);
+  ASSERT_LE(snapshot.latency_p50, snapshot.latency_max);
+
+  std::ostringstream json;
+  snapshot.writeJson(json);
+  ASSERT_EQ(json.str().find("{\"updates\":4,"), 0u);
+
+  // Detached, the controller no longer records.
+  pid.setStats(nullptr);
+  pid.calculate(10.0, 10.0);
+  ASSERT_EQ(stats.snapshot().updates, 4u);
+}
+#endif
+
+// test5: The JSON of a diverged controller is still valid: non-finite values
+// become null and finite ones read back exactly.
+TEST(PIDStatsTest, JsonOfDivergedController) {
+  PIDStats stats;
+  const double integral = 1.0 / 3.0;
+  stats.record(0.1, 5.0, 5.0, -5.0, integral, 100);
+  stats.record(std::numeric_limits<double>::infinity(), 5.0, 5.0, -5.0,
+               std::numeric_limits<double>::quiet_NaN(), 100);
+
+  std::ostringstream json;
+  json.precision(3);
+  stats.snapshot().writeJson(json);
+  const std::string text = json.str();
+  ASSERT_EQ(json.precision(), 3);
+  ASSERT_NE(text.find("\"integral\":null"), std::string::npos);
+
+  // Every value of the flat object is null or a complete number.
+  ASSERT_EQ(text.front(), '{');
+  ASSERT_EQ(text.back(), '}');
+  std::size_t pos = 1;
+  while (pos < text.size()) {
+    ASSERT_EQ(text[pos], '"');
+    std::size_t colon = text.find("\":", pos + 1);
+    ASSERT_NE(colon, std::string::npos);
+    const std::string key = text.substr(pos + 1, colon - pos - 1);
+    std::size_t end = text.find_first_of(",}", colon + 2);
+    const std::string value = text.substr(colon + 2, end - colon - 2);
+    if (value != "null") {
+      char *stop = nullptr;
+      double number = std::strtod(value.c_str(), &stop);
+      ASSERT_EQ(*stop, '\0') << key << ": " << value;
+      if (key == "integral_peak") ASSERT_EQ(number, integral);
+    } else {
+      ASSERT_TRUE(key == "integral" || key == "error_mean" ||
+                  key == "error_variance")
+          << key;
+    }
+    pos = end + 1;
+  }
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "pid.hpp"
+
+// test1: A copy carries the state of the original but evolves independently.
+TEST(PIDValueTest, CopyIsIndependent) {
+  PID original(1.0, 100.0, -100.0, 1.0, 0.1, 0.5);
+  PID twin(1.0, 100.0, -100.0, 1.0, 0.1, 0.5);
+  original.calculate(10.0, 0.0);
+  twin.calculate(10.0, 0.0);
+
+  PID copy(original);
+
+  // Advancing the original must not affect the copy, which continues from the
+  // state it was copied with: P = 10, I = 0.5 * 20, D = 0.
+  original.calculate(50.0, 0.0);
+  double output = copy.calculate(10.0, 0.0);
+  ASSERT_DOUBLE_EQ(output, 20.0);
+  ASSERT_EQ(output, twin.calculate(10.0, 0.0));
+
+  // Same again with copy assignment: I = 0.5 * 30.
+  PID assigned(1.0, 1.0, -1.0, 0.0, 0.0, 0.0);
+  assigned = twin;
+  twin.calculate(50.0, 0.0);
+  ASSERT_DOUBLE_EQ(assigned.calculate(10.0, 0.0), 25.0);
+}
+
+// test2: A moved-to controller continues where the moved-from one stopped.
+TEST(PIDValueTest, MoveKeepsState) {
+  PID source(1.0, 100.0, -100.0, 1.0, 0.1, 0.5);
+  PID twin(1.0, 100.0, -100.0, 1.0, 0.1, 0.5);
+  source.calculate(10.0, 0.0);
+  twin.calculate(10.0, 0.0);
+
+  PID moved(std::move(source));
+  ASSERT_EQ(moved.calculate(10.0, 0.0), twin.calculate(10.0, 0.0));
+}
+
+// test3: Controllers stored in a vector survive reallocation.
+TEST(PIDValueTest, VectorOfControllers) {
+  std::vector<PID> pids;
+  for (int i = 0; i < 100; ++i) pids.emplace_back(1.0, 100.0, -100.0, 1.0, 0.1, 0.5);
+  for (PID &pid : pids) ASSERT_NEAR(pid.calculate(10.0, 0.0), 16.0, 0.01);
+
+  pids.reserve(1000);
+  for (PID &pid : pids) ASSERT_NEAR(pid.calculate(10.0, 0.0), 20.0, 0.01);
+}
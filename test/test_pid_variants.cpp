@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "pid_variants.hpp"
+#include "plant.hpp"
+
+// Both variants halve the footprint of BasicPID<double>.
+static_assert(sizeof(Q16_16) == 4, "Q16.16 must be stored in 32 bits");
+static_assert(sizeof(FloatPID) * 2 == sizeof(BasicPID<double>),
+              "FloatPID must be half the size of the double controller");
+static_assert(sizeof(FixedPID) * 2 == sizeof(BasicPID<double>),
+              "FixedPID must be half the size of the double controller");
+
+namespace {
+
+const double kDt = 0.1;
+const double kMax = 100.0;
+const double kMin = -100.0;
+const double kKp = 0.8;
+const double kKd = 0.05;
+const double kKi = 0.5;
+
+// Runs random samples through a variant and the double reference, copying
+// the reference state into the variant before each update, and checks every
+// output against the documented bound of one update.
+template <typename T, typename Bound>
+void checkAgainstDouble(Bound bound) {
+  BasicPID<double> reference(kDt, kMax, kMin, kKp, kKd, kKi);
+  BasicPID<T> variant{T(kDt), T(kMax), T(kMin), T(kKp), T(kKd), T(kKi)};
+
+  std::mt19937 random(42);
+  std::uniform_real_distribution<double> pvs(-60.0, 60.0);
+  for (int n = 0; n < 10000; ++n) {
+    const double setpoint = 10.0, pv = pvs(random);
+    const PIDState<double> before = reference.state();
+    variant.restore({T(before.integral), T(before.pre_error), T(0.0)});
+
+    PIDContributions<double> terms;
+    const double expected = reference.calculate(setpoint, pv, terms);
+    const double actual =
+        static_cast<double>(variant.calculate(T(setpoint), T(pv)));
+    ASSERT_LE(std::fabs(actual - expected),
+              bound(setpoint, pv, before, reference.state(), terms))
+        << "sample " << n;
+  }
+}
+
+}  // namespace
+
+// test1: Q16.16 arithmetic rounds to nearest and saturates.
+TEST(FixedPointTest, RoundingAndSaturation) {
+  const double q = Q16_16::resolution();
+  ASSERT_EQ(Q16_16(1.5).raw(), 3 << 15);
+  ASSERT_EQ(Q16_16(0.4 * q).raw(), 0);
+  ASSERT_EQ(Q16_16(0.6 * q).raw(), 1);
+  ASSERT_EQ(Q16_16(-0.6 * q).raw(), -1);
+  ASSERT_EQ((Q16_16(1.5) * Q16_16(-2.0)).toDouble(), -3.0);
+  ASSERT_EQ((Q16_16(1.0) / Q16_16(3.0)).raw(), 21845);
+  ASSERT_EQ((Q16_16(-1.0) / Q16_16(3.0)).raw(), -21845);
+
+  const Q16_16 big(30000.0);
+  ASSERT_EQ((big + big).raw(), Q16_16::kRawMax);
+  ASSERT_EQ((-big - big).raw(), Q16_16::kRawMin);
+  ASSERT_EQ((big * big).raw(), Q16_16::kRawMax);
+  ASSERT_EQ((big * -big).raw(), Q16_16::kRawMin);
+  ASSERT_EQ((Q16_16(1.0) / Q16_16(0.0)).raw(), Q16_16::kRawMax);
+  ASSERT_EQ(Q16_16(1e12).raw(), Q16_16::kRawMax);
+  ASSERT_EQ(Q16_16(std::nan("")).raw(), 0);
+}
+
+// test2: Every float update stays within the documented bound.
+TEST(PIDVariantsTest, FloatWithinBound) {
+  checkAgainstDouble<float>([](double setpoint, double pv,
+                               const PIDState<double> &,
+                               const PIDState<double> &,
+                               const PIDContributions<double> &terms) {
+    const double eps = std::ldexp(1.0, -24);
+    return eps *
+           (4 * (std::fabs(terms.p) + std::fabs(terms.i) + std::fabs(terms.d)) +
+            (kKp + 2 * kKd / kDt) * (std::fabs(setpoint) + std::fabs(pv)));
+  });
+}
+
+// test3: Every Q16.16 update stays within the documented bound.
+TEST(PIDVariantsTest, FixedWithinBound) {
+  checkAgainstDouble<Q16_16>([](double, double, const PIDState<double> &before,
+                                const PIDState<double> &after,
+                                const PIDContributions<double> &) {
+    const double q = Q16_16::resolution();
+    const double e = std::fabs(after.pre_error);
+    const double de = std::fabs(after.pre_error - before.pre_error);
+    const double integral = std::fabs(after.integral);
+    return q * (kKp + e + kKi * (1 + kDt + e + integral) +
+                kKd * (2 / kDt + de * (1 + 1 / (2 * kDt * kDt))) + de / kDt +
+                3);
+  });
+}
+
+// test4: In a closed loop the variants track the double controller.
+TEST(PIDVariantsTest, ClosedLoopTracksDouble) {
+  BasicPID<double> reference(kDt, kMax, kMin, kKp, kKd, kKi);
+  FloatPID single{float(kDt), float(kMax), float(kMin),
+                  float(kKp), float(kKd), float(kKi)};
+  FixedPID fixed{Q16_16(kDt), Q16_16(kMax), Q16_16(kMin),
+                 Q16_16(kKp), Q16_16(kKd), Q16_16(kKi)};
+  FirstOrderLag plants[3] = {FirstOrderLag(2.0, 1.0, kDt),
+                             FirstOrderLag(2.0, 1.0, kDt),
+                             FirstOrderLag(2.0, 1.0, kDt)};
+
+  for (int n = 0; n < 500; ++n) {
+    plants[0].step(reference.calculate(10.0, plants[0].output()));
+    plants[1].step(single.calculate(10.0f, float(plants[1].output())));
+    plants[2].step(static_cast<double>(
+        fixed.calculate(Q16_16(10.0), Q16_16(plants[2].output()))));
+    ASSERT_NEAR(plants[1].output(), plants[0].output(), 1e-4);
+    ASSERT_NEAR(plants[2].output(), plants[0].output(), 1e-2);
+  }
+  ASSERT_NEAR(plants[2].output(), 10.0, 1e-3);
+}
+
+// test5: A fixed-point controller saturates its output instead of wrapping.
+TEST(PIDVariantsTest, FixedSaturates) {
+  FixedPID pid(Q16_16(0.01), Q16_16(30000.0), Q16_16(-30000.0),
+               Q16_16(1000.0), Q16_16(0.0), Q16_16(0.0));
+  ASSERT_EQ(pid.calculate(Q16_16(20000.0), Q16_16(-20000.0)),
+            Q16_16(30000.0));
+  ASSERT_EQ(pid.calculate(Q16_16(-20000.0), Q16_16(20000.0)),
+            Q16_16(-30000.0));
+}
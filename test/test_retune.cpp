@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "basic_pid.hpp"
+#include "pid.hpp"
+#include "pid_bank.hpp"
+#include "pid_scheduler.hpp"
+#include "pid_tuning.hpp"
+
+// test1: Readers never see a torn value while a writer keeps storing.
+TEST(SeqLockTest, ConsistentUnderConcurrentStores) {
+  PIDTuning tuning({1.0, -1.0, 1.0, 1.0, 1.0});
+  std::atomic<bool> done(false);
+  std::thread writer([&] {
+    for (int n = 2; n < 20000; ++n) {
+      double k = n;
+      tuning.store({k, -k, k, k, k});
+    }
+    done = true;
+  });
+
+  std::uint64_t last = 0;
+  while (!done) {
+    std::uint64_t version;
+    PIDParameters p = tuning.load(&version);
+    ASSERT_EQ(version % 2, 0u);
+    ASSERT_GE(version, last);
+    last = version;
+    ASSERT_EQ(p.min, -p.max);
+    ASSERT_EQ(p.Kp, p.max);
+    ASSERT_EQ(p.Kd, p.max);
+    ASSERT_EQ(p.Ki, p.max);
+  }
+  writer.join();
+  ASSERT_EQ(tuning.load().Kp, 19999.0);
+}
+
+// test2: A PID attached to a tuning follows every store() at its next
+// calculate(), exactly like a controller retuned directly.
+TEST(RetuneTest, PIDFollowsTuning) {
+  PIDTuning tuning({50.0, -50.0, 1.0, 0.1, 0.5});
+  PID pid(0.1, 50.0, -50.0, 1.0, 0.1, 0.5);
+  BasicPID<double> reference(0.1, 50.0, -50.0, 1.0, 0.1, 0.5);
+  pid.setTuning(&tuning);
+
+  ASSERT_EQ(pid.calculate(10.0, 1.0), reference.calculate(10.0, 1.0));
+  tuning.store({5.0, -5.0, 2.0, 0.2, 0.25});
+  reference.retune(2.0, 0.2, 0.25);
+  reference.setLimits(5.0, -5.0);
+  for (double pv : {2.0, 4.0, 9.0, 9.9})
+    ASSERT_EQ(pid.calculate(10.0, pv), reference.calculate(10.0, pv));
+
+  // Detached, the controller keeps its last parameters.
+  pid.setTuning(nullptr);
+  tuning.store({50.0, -50.0, 1.0, 0.1, 0.5});
+  ASSERT_EQ(pid.calculate(10.0, 10.0), reference.calculate(10.0, 10.0));
+}
+
+// test3: Retuning keeps the integral term, so the output does not jump when
+// only Ki changes.
+TEST(RetuneTest, RetuneIsBumpless) {
+  BasicPID<double, kPI> pid(0.1, 100.0, -100.0, 1.0, 0.0, 0.5);
+  for (int n = 0; n < 10; ++n) pid.calculate(10.0, 5.0);
+  const double integral_term = pid.Ki() * pid.integral();
+
+  pid.retune(1.0, 0.0, 2.0);
+  ASSERT_NEAR(pid.Ki() * pid.integral(), integral_term, 1e-12);
+  // Zero error: the output is the integral term alone.
+  ASSERT_NEAR(pid.calculate(10.0, 10.0), integral_term, 1e-12);
+}
+
+// test4: After a bumpless transfer, the controller starts from the manual
+// output.
+TEST(RetuneTest, BumplessTransfer) {
+  PID pid(0.1, 100.0, -100.0, 2.0, 0.5, 0.5);
+  pid.bumplessTransfer(37.0, 10.0, 10.0);
+  ASSERT_NEAR(pid.calculate(10.0, 10.0), 37.0, 1e-12);
+
+  PIDBank bank;
+  bank.add(0.1, 100.0, -100.0, 2.0, 0.5, 0.5);
+  bank.bumplessTransfer(0, 37.0, 10.0, 10.0);
+  double setpoint = 10.0, pv = 10.0, output;
+  bank.calculate(&setpoint, &pv, &output);
+  ASSERT_NEAR(output, 37.0, 1e-12);
+}
+
+// test5: The transfer accounts for the integration of a non-zero error in the
+// first automatic update.
+TEST(RetuneTest, BumplessTransferWithError) {
+  PID pid(0.1, 100.0, -100.0, 0.8, 0.05, 0.5);
+  pid.bumplessTransfer(20.0, 10.0, 6.0);
+  ASSERT_NEAR(pid.calculate(10.0, 6.0), 20.0, 1e-12);
+
+  PIDBank bank;
+  bank.add(0.1, 100.0, -100.0, 0.8, 0.05, 0.5);
+  bank.bumplessTransfer(0, 20.0, 10.0, 6.0);
+  double setpoint = 10.0, pv = 6.0, output;
+  bank.calculate(&setpoint, &pv, &output);
+  ASSERT_NEAR(output, 20.0, 1e-12);
+}
+
+// test6: A restored snapshot continues the loop exactly.
+TEST(RetuneTest, SnapshotRestore) {
+  PID a(0.1, 50.0, -50.0, 1.0, 0.1, 0.5);
+  PID b(0.1, 50.0, -50.0, 1.0, 0.1, 0.5);
+  for (double pv : {0.0, 3.0, 6.0}) a.calculate(10.0, pv);
+
+  b.restore(a.state());
+  for (double pv : {8.0, 9.0, 11.0})
+    ASSERT_EQ(a.calculate(10.0, pv), b.calculate(10.0, pv));
+}
+
+// test7: A saved scheduler state warm-starts a new scheduler bit for bit.
+TEST(RetuneTest, SchedulerSaveLoadState) {
+  const std::size_t count = 100;
+  PIDScheduler a(2), b(2);
+  for (std::size_t i = 0; i < count; ++i) {
+    a.add(0.1, 50.0, -50.0, 1.0 + i % 5, 0.1, 0.5);
+    b.add(0.1, 50.0, -50.0, 1.0 + i % 5, 0.1, 0.5);
+    a.setpoints()[i] = b.setpoints()[i] = 10.0;
+  }
+  for (int t = 0; t < 3; ++t) {
+    for (std::size_t i = 0; i < count; ++i) a.pvs()[i] = 0.1 * i + t;
+    a.tick();
+  }
+
+  std::stringstream state;
+  a.saveState(state);
+  b.loadState(state);
+  for (std::size_t i = 0; i < count; ++i) a.pvs()[i] = b.pvs()[i] = 5.0;
+  a.tick();
+  b.tick();
+  for (std::size_t i = 0; i < count; ++i)
+    ASSERT_EQ(a.outputs()[i], b.outputs()[i]);
+
+  // A state of a different size, or garbage, is rejected.
+  PIDBank small;
+  small.add(0.1, 1.0, -1.0, 1.0, 0.0, 0.0);
+  std::stringstream again;
+  a.saveState(again);
+  ASSERT_THROW(small.loadState(again), std::runtime_error);
+  std::stringstream garbage("not a state at all, just some text");
+  ASSERT_THROW(small.loadState(garbage), std::runtime_error);
+}
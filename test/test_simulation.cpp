@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "basic_pid.hpp"
+#include "pid.hpp"
+#include "plant.hpp"
+#include "simulation.hpp"
+#include "step_metrics.hpp"
+
+// test1: The first-order lag reaches 1 - 1/e of its final value after one time
+// constant, whatever the sample period.
+TEST(PlantTest, FirstOrderLagTimeConstant) {
+  FirstOrderLag plant(2.0, 1.0, 0.01);
+  for (int k = 0; k < 100; ++k) plant.step(1.0);
+  ASSERT_NEAR(plant.output(), 2.0 * (1.0 - std::exp(-1.0)), 1e-9);
+}
+
+// test2: Dead time delays the input by a whole number of samples.
+TEST(PlantTest, DeadTimeDelaysInput) {
+  auto plant = withDeadTime(Integrator(1.0, 1.0), 3);
+  ASSERT_EQ(plant.step(1.0), 0.0);
+  ASSERT_EQ(plant.step(1.0), 0.0);
+  ASSERT_EQ(plant.step(1.0), 0.0);
+  ASSERT_EQ(plant.step(1.0), 1.0);
+  ASSERT_EQ(plant.step(1.0), 2.0);
+}
+
+// test3: The metrics of a hand-made trajectory.
+TEST(StepMetricsTest, KnownTrajectory) {
+  StepMetrics metrics(0.0, 1.0, 1.0, 0.05);
+  const double ys[] = {0.05, 0.5, 0.95, 1.2, 1.02, 0.99, 1.0};
+  for (double y : ys) metrics.update(y);
+
+  ASSERT_EQ(metrics.steps(), 7u);
+  ASSERT_DOUBLE_EQ(metrics.riseTime(), 3.0 - 2.0);  // 10% at t=2, 90% at t=3
+  ASSERT_NEAR(metrics.overshoot(), 0.2, 1e-12);
+  ASSERT_DOUBLE_EQ(metrics.settlingTime(), 4.0);  // last outside at t=4
+  ASSERT_NEAR(metrics.iae(), 0.95 + 0.5 + 0.05 + 0.2 + 0.02 + 0.01, 1e-12);
+}
+
+// test4: A PI loop on a first-order plant settles on the setpoint, and the
+// same loop through PID gives the same metrics as through BasicPID.
+TEST(SimulationTest, PIOnFirstOrderLagSettles) {
+  const double dt = 0.01;
+  BasicPID<double> basic(dt, 10.0, -10.0, 2.0, 0.0, 4.0);
+  PID pid(dt, 10.0, -10.0, 2.0, 0.0, 4.0);
+  FirstOrderLag plant_a(1.0, 0.5, dt), plant_b(1.0, 0.5, dt);
+
+  StepMetrics a = simulateStep(basic, plant_a, 1.0, 2000, dt);
+  StepMetrics b = simulateStep(pid, plant_b, 1.0, 2000, dt);
+
+  ASSERT_NEAR(plant_a.output(), 1.0, 1e-3);
+  ASSERT_TRUE(std::isfinite(a.settlingTime()));
+  ASSERT_LT(a.riseTime(), 1.0);
+  ASSERT_EQ(a.iae(), b.iae());
+  ASSERT_EQ(a.settlingTime(), b.settlingTime());
+}
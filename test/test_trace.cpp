@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+
+#include <csignal>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "pid.hpp"
+#include "trace_file.hpp"
+#include "trace_replay.hpp"
+#include "trace_ring.hpp"
+
+// test1: The ring keeps records in order and drops them when full.
+TEST(TraceRingTest, PushPopAndDrop) {
+  TraceRing ring(3);  // rounded up to 4
+  TraceRecord record = {};
+  for (int k = 0; k < 5; ++k) {
+    record.setpoint = k;
+    bool pushed = ring.tryPush(record);
+    ASSERT_EQ(pushed, k < 4);
+  }
+  ASSERT_EQ(ring.dropped(), 1u);
+
+  TraceRecord out[8];
+  ASSERT_EQ(ring.pop(out, 8), 4u);
+  for (int k = 0; k < 4; ++k) ASSERT_EQ(out[k].setpoint, k);
+  ASSERT_EQ(ring.pop(out, 8), 0u);
+}
+
+// test2: A traced run written to disk replays to the same outputs, and the
+// recorded contributions add up to the unclamped output. Every third update
+// uses its own dt, which the trace records.
+TEST(TraceFileTest, RecordAndReplay) {
+  const std::string path = ::testing::TempDir() + "pid_trace_test.bin";
+  const int steps = 10000;
+
+  TraceRing ring(1 << 16);
+  std::vector<double> outputs;
+  {
+    TraceWriter writer(ring, path, 1 << 12);
+    PID pids[2] = {PID(0.1, 100.0, -100.0, 0.1, 0.01, 0.5),
+                   PID(0.1, 100.0, -100.0, 0.1, 0.01, 0.5)};
+    pids[0].setTracer(&ring, 0);
+    pids[1].setTracer(&ring, 1);
+    for (int k = 0; k < steps; ++k) {
+      double pv = (k % 7) - 3.0;
+      double dt = 0.05 + 0.01 * (k % 5);
+      outputs.push_back(k % 3 == 0 ? pids[k & 1].calculate(10.0, pv, dt)
+                                   : pids[k & 1].calculate(10.0, pv));
+    }
+    writer.stop();
+    ASSERT_EQ(writer.written(), static_cast<std::uint64_t>(steps));
+  }
+
+  TraceReader trace(path);
+  ASSERT_EQ(trace.size(), static_cast<std::uint64_t>(steps));
+  ASSERT_EQ(trace.header().dropped, 0u);
+
+  PID replay[2] = {PID(0.1, 100.0, -100.0, 0.1, 0.01, 0.5),
+                   PID(0.1, 100.0, -100.0, 0.1, 0.01, 0.5)};
+  for (std::uint64_t k = 0; k < trace.size(); ++k) {
+    const TraceRecord &record = trace[k];
+    ASSERT_EQ(record.controller, k & 1);
+    ASSERT_EQ(record.output, outputs[k]);
+    PID &pid = replay[record.controller];
+    if (k % 3 == 0) {
+      ASSERT_EQ(record.flags, kTraceExplicitDt);
+      ASSERT_EQ(record.dt, 0.05 + 0.01 * (k % 5));
+      ASSERT_EQ(pid.calculate(record.setpoint, record.pv, record.dt),
+                record.output);
+    } else {
+      ASSERT_EQ(record.flags, 0u);
+      ASSERT_EQ(record.dt, 0.1);
+      ASSERT_EQ(pid.calculate(record.setpoint, record.pv), record.output);
+    }
+    if (record.output > -100.0 && record.output < 100.0) {
+      ASSERT_NEAR(record.p + record.i + record.d, record.output, 1e-9);
+    }
+  }
+
+  std::remove(path.c_str());
+}
+
+// test3: When the file cannot grow, the records already written stay readable
+// and the rest are counted as dropped.
+TEST(TraceFileTest, GrowthFailureKeepsRecords) {
+  const std::string path = ::testing::TempDir() + "pid_trace_full.bin";
+  const std::uint64_t records = 20000;
+  const rlim_t limit = 512 << 10;  // room for two growth steps
+
+  TraceRing ring(1 << 15);
+  TraceRecord record = {};
+  for (std::uint64_t k = 0; k < records; ++k) {
+    record.setpoint = static_cast<double>(k);
+    ASSERT_TRUE(ring.tryPush(record));
+  }
+
+  struct rlimit saved;
+  ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &saved), 0);
+  struct rlimit limited = saved;
+  limited.rlim_cur = limit;
+  void (*handler)(int) = std::signal(SIGXFSZ, SIG_IGN);
+  ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limited), 0);
+
+  std::uint64_t written = 0;
+  std::uint64_t dropped = 0;
+  {
+    TraceWriter writer(ring, path, 1 << 12);
+    writer.stop();
+    written = writer.written();
+    dropped = writer.dropped();
+  }
+  ::setrlimit(RLIMIT_FSIZE, &saved);
+  std::signal(SIGXFSZ, handler);
+
+  ASSERT_EQ(written, (limit - sizeof(TraceFileHeader)) / sizeof(TraceRecord));
+  ASSERT_EQ(written + dropped, records);
+
+  TraceReader trace(path);
+  ASSERT_EQ(trace.size(), written);
+  ASSERT_EQ(trace.header().dropped, dropped);
+  ASSERT_EQ(trace[written - 1].setpoint, static_cast<double>(written - 1));
+
+  std::remove(path.c_str());
+}
+
+// test4: Controllers are replayed by id, so the largest 32-bit ids work and
+// only cost the controllers that appear.
+TEST(TraceFileTest, ReplayLargeControllerIds) {
+  const std::string path = ::testing::TempDir() + "pid_trace_ids.bin";
+  const std::uint32_t ids[] = {UINT32_MAX, 4000000000u, 0};
+
+  TraceRing ring(1 << 10);
+  std::vector<double> outputs;
+  {
+    TraceWriter writer(ring, path, 1 << 12);
+    std::vector<PID> pids(3, PID(0.1, 100.0, -100.0, 0.1, 0.01, 0.5));
+    for (int k = 0; k < 3; ++k) pids[k].setTracer(&ring, ids[k]);
+    for (int k = 0; k < 30; ++k)
+      outputs.push_back(pids[k % 3].calculate(10.0, 0.5 * (k % 3) - k));
+    writer.stop();
+  }
+
+  TraceReader trace(path);
+  ASSERT_EQ(trace.size(), outputs.size());
+  TraceReplayer replayer(PID(0.1, 100.0, -100.0, 0.1, 0.01, 0.5));
+  for (std::uint64_t k = 0; k < trace.size(); ++k) {
+    ASSERT_EQ(trace[k].controller, ids[k % 3]);
+    ASSERT_EQ(replayer.replay(trace[k]), outputs[k]);
+  }
+  ASSERT_EQ(replayer.controllers(), 3u);
+
+  std::remove(path.c_str());
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "basic_pid.hpp"
+#include "pid.hpp"
+#include "pid_bank.hpp"
+
+// test1: Passing the nominal dt explicitly gives exactly the fixed-dt result.
+TEST(VariableDtTest, NominalDtMatchesFixedPath) {
+  PID fixed(0.1, 100.0, -100.0, 1.0, 0.1, 0.5);
+  PID variable(0.1, 100.0, -100.0, 1.0, 0.1, 0.5);
+  const double pvs[] = {0.0, 2.0, 4.5, 7.0, 9.0, 11.0};
+  for (double pv : pvs)
+    ASSERT_EQ(variable.calculate(10.0, pv, 0.1), fixed.calculate(10.0, pv));
+}
+
+// test2: The interval is used for both the integral and the derivative.
+TEST(VariableDtTest, IrregularInterval) {
+  BasicPID<double> pid(1.0, 100.0, -100.0, 1.0, 0.1, 0.5);
+
+  // P = 10, I = 0.5 * 10 * 2 = 10, D = 0.1 * 10 / 2 = 0.5
+  ASSERT_NEAR(pid.calculate(10.0, 0.0, 2.0), 20.5, 1e-12);
+  ASSERT_NEAR(pid.integral(), 20.0, 1e-12);
+}
+
+// test3: Timestamps drive the interval; a dropped sample doubles it, and a
+// repeated timestamp holds the state.
+TEST(VariableDtTest, TimestampDriven) {
+  PID timed(0.1, 100.0, -100.0, 1.0, 0.1, 0.5);
+  PID reference(0.1, 100.0, -100.0, 1.0, 0.1, 0.5);
+
+  ASSERT_EQ(timed.calculateAt(10.0, 0.0, 5.0), reference.calculate(10.0, 0.0));
+  ASSERT_EQ(timed.calculateAt(10.0, 1.0, 5.1),
+            reference.calculate(10.0, 1.0, 5.1 - 5.0));
+  // The sample at 5.2 was dropped.
+  ASSERT_EQ(timed.calculateAt(10.0, 3.0, 5.3),
+            reference.calculate(10.0, 3.0, 5.3 - 5.1));
+  // Repeated and out-of-order timestamps do not advance the state.
+  double held = timed.calculateAt(10.0, 3.0, 5.3);
+  ASSERT_EQ(held, timed.calculateAt(10.0, 3.0, 5.25));
+  ASSERT_EQ(timed.calculateAt(10.0, 4.0, 5.4),
+            reference.calculate(10.0, 4.0, 5.4 - 5.3));
+}
+
+// test4: The bank's per-sample dt path matches PID::calculate with dt.
+TEST(VariableDtTest, BankPerSampleDt) {
+  const std::size_t count = 300;  // more than one block of reciprocals
+  PIDBank bank;
+  std::vector<PID> pids;
+  for (std::size_t i = 0; i < count; ++i) {
+    bank.add(0.1, 20.0, -20.0, 1.0 + i % 5, 0.05, 0.5);
+    pids.emplace_back(0.1, 20.0, -20.0, 1.0 + i % 5, 0.05, 0.5);
+  }
+
+  std::vector<double> setpoints(count), pvs(count), dts(count), outputs(count);
+  for (int step = 0; step < 4; ++step) {
+    for (std::size_t i = 0; i < count; ++i) {
+      setpoints[i] = 5.0 + step;
+      pvs[i] = 0.01 * static_cast<double>(i);
+      dts[i] = 0.05 + 0.001 * static_cast<double>((i + step) % 17);
+    }
+    bank.calculate(0, count, setpoints.data(), pvs.data(), dts.data(),
+                   outputs.data());
+    for (std::size_t i = 0; i < count; ++i)
+      ASSERT_EQ(outputs[i], pids[i].calculate(setpoints[i], pvs[i], dts[i]));
+  }
+}
+
+// test5: A non-positive dt holds a bank controller's state, as in PID.
+TEST(VariableDtTest, BankHoldsOnNonPositiveDt) {
+  const std::size_t count = 6;
+  PIDBank bank;
+  std::vector<PID> pids;
+  for (std::size_t i = 0; i < count; ++i) {
+    bank.add(0.1, 20.0, -20.0, 1.0, 0.05, 0.5);
+    pids.emplace_back(0.1, 20.0, -20.0, 1.0, 0.05, 0.5);
+  }
+
+  const double dts[][count] = {{0.1, 0.1, 0.1, 0.1, 0.1, 0.1},
+                               {0.1, 0.0, -0.1, 0.2, 0.0, 0.05},
+                               {0.1, 0.1, 0.1, 0.0, 0.1, -1.0},
+                               {0.1, 0.1, 0.1, 0.1, 0.1, 0.1}};
+  std::vector<double> setpoints(count), pvs(count), outputs(count);
+  for (int step = 0; step < 4; ++step) {
+    for (std::size_t i = 0; i < count; ++i) {
+      setpoints[i] = 5.0;
+      pvs[i] = 0.5 * step + 0.1 * static_cast<double>(i);
+    }
+    bank.calculate(0, count, setpoints.data(), pvs.data(), dts[step],
+                   outputs.data());
+    for (std::size_t i = 0; i < count; ++i) {
+      ASSERT_TRUE(std::isfinite(outputs[i]));
+      ASSERT_EQ(outputs[i],
+                pids[i].calculate(setpoints[i], pvs[i], dts[step][i]));
+      ASSERT_EQ(bank.state(i).integral, pids[i].state().integral);
+      ASSERT_EQ(bank.state(i).pre_error, pids[i].state().pre_error);
+    }
+  }
+}